@@ -2,6 +2,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -25,6 +26,26 @@ void from_json(const json& j, BasicSetting& p)
     {
         p.plotSamplingRate = 1; // Default
     }
+    p.dbusTimeout = j.value("dbustimeout", 1.0);
+    p.sensorMaxAge = j.value("sensormaxage", 2.0);
+    p.backend = j.value("backend", std::string("dbus"));
+    p.compactStorage = j.value("compactstorage", false);
+    p.logFlushBytes = j.value("logflushbytes", 4096);
+    p.logFlushInterval = j.value("logflushinterval", 1.0);
+    p.logFormat = j.value("logformat", std::string("csv"));
+    p.logDeflate = j.value("logcompression", false);
+    p.steadyState = j.value("steadystate", false);
+    p.steadySlope = j.value("steadyslope", 0.005);
+    p.steadyRmse = j.value("steadyrmse", 0.25);
+    p.steadyHold = j.value("steadyhold", 30.0);
+    p.onlineFopdt = j.value("onlinefopdt", false);
+    p.onlineStop = j.value("onlinestop", false);
+    p.onlineTolerance = j.value("onlinetolerance", 0.05);
+    p.onlineHold = j.value("onlinehold", 30.0);
+    p.onlineMaxDeadTime = j.value("onlinemaxdeadtime", 60.0);
+    p.fopdtSolver = j.value("fopdtsolver", std::string("lm"));
+    p.multiStartSeeds = j.value("multistartseeds", 0);
+    p.modelSelection = j.value("modelselection", true);
 }
 
 void from_json(const json& j, ExperimentConfig& p)
@@ -36,6 +57,112 @@ void from_json(const json& j, ExperimentConfig& p)
     j.at("initialiterations").get_to(p.initialIterations);
     j.at("aftertriggeriterations").get_to(p.afterTriggerIterations);
     j.at("tempsensor").get_to(p.tempSensor);
+    p.observedSensors = {p.tempSensor};
+    for (const auto& s :
+         j.value("observedsensors", std::vector<std::string>{}))
+    {
+        if (std::find(p.observedSensors.begin(), p.observedSensors.end(),
+                      s) == p.observedSensors.end())
+            p.observedSensors.push_back(s);
+    }
+    p.priority = j.value("priority", 0);
+    p.coupledSensors =
+        j.value("coupledsensors", std::vector<std::string>{});
+}
+
+void from_json(const json& j, FanGroup& p)
+{
+    j.at("name").get_to(p.name);
+    j.at("fans").get_to(p.fans);
+}
+
+void from_json(const json& j, MimoConfig& p)
+{
+    j.at("name").get_to(p.name);
+    j.at("fangroups").get_to(p.fanGroups);
+    j.at("basepwmduty").get_to(p.basePwmDuty);
+    j.at("steppwmduty").get_to(p.stepPwmDuty);
+    j.at("sensors").get_to(p.sensors);
+    j.at("settleiterations").get_to(p.settleIterations);
+    j.at("holditerations").get_to(p.holdIterations);
+    p.stepInterval = j.value("stepinterval", p.holdIterations);
+    p.priority = j.value("priority", 0);
+    p.coupledSensors =
+        j.value("coupledsensors", std::vector<std::string>{});
+}
+
+void from_json(const json& j, RelayConfig& p)
+{
+    j.at("name").get_to(p.name);
+    j.at("fans").get_to(p.fans);
+    j.at("tempsensor").get_to(p.tempSensor);
+    j.at("highpwmduty").get_to(p.highPwmDuty);
+    j.at("lowpwmduty").get_to(p.lowPwmDuty);
+    if (j.contains("setpoint"))
+        p.setpoint = j.at("setpoint").get<double>();
+    p.hysteresis = j.value("hysteresis", 0.2);
+    p.settleIterations = j.value("settleiterations", 600);
+    j.at("maxiterations").get_to(p.maxIterations);
+    p.cycles = j.value("cycles", 3);
+    p.cycleTolerance = j.value("cycletolerance", 0.05);
+    p.priority = j.value("priority", 0);
+    p.coupledSensors =
+        j.value("coupledsensors", std::vector<std::string>{});
+}
+
+void from_json(const json& j, ExcitationConfig& p)
+{
+    j.at("name").get_to(p.name);
+    j.at("fans").get_to(p.fans);
+    j.at("tempsensor").get_to(p.tempSensor);
+    j.at("signal").get_to(p.signal);
+    j.at("basepwmduty").get_to(p.basePwmDuty);
+    p.levels = j.value("levels", std::vector<double>{});
+    p.lowPwmDuty = j.value("lowpwmduty", p.basePwmDuty);
+    p.highPwmDuty = j.value("highpwmduty", p.basePwmDuty);
+    p.stairSteps = j.value("steps", 4);
+    p.prbsOrder = j.value("prbsorder", 6);
+    p.settleIterations = j.value("settleiterations", 600);
+    j.at("holditerations").get_to(p.holdIterations);
+    p.tailIterations = j.value("tailiterations", p.holdIterations);
+    p.imcRatio = j.value("imcratio", 1.0);
+    p.priority = j.value("priority", 0);
+    p.coupledSensors =
+        j.value("coupledsensors", std::vector<std::string>{});
+}
+
+void from_json(const json& j, FOPDTSpec& p)
+{
+    j.at("k").get_to(p.k);
+    j.at("tau").get_to(p.tau);
+    j.at("theta").get_to(p.theta);
+}
+
+void from_json(const json& j, ValidationConfig& p)
+{
+    j.at("name").get_to(p.name);
+    j.at("fans").get_to(p.fans);
+    j.at("tempsensor").get_to(p.tempSensor);
+    p.kp = j.value("kp", 0.0);
+    p.ki = j.value("ki", 0.0);
+    p.kd = j.value("kd", 0.0);
+    if (j.contains("model"))
+        p.model = j.at("model").get<FOPDTSpec>();
+    p.imcRatio = j.value("imcratio", 1.0);
+    j.at("initialpwmduty").get_to(p.initialPwmDuty);
+    p.minPwmDuty = j.value("minpwmduty", 0.0);
+    p.maxPwmDuty = j.value("maxpwmduty", 255.0);
+    if (j.contains("setpoint"))
+        p.setpoint = j.at("setpoint").get<double>();
+    p.setpointStep = j.value("setpointstep", -2.0);
+    p.settleBand = j.value("settleband", 0.5);
+    p.maxOvershoot = j.value("maxovershoot", 20.0);
+    p.maxSettlingTime = j.value("maxsettlingtime", 0.0);
+    p.settleIterations = j.value("settleiterations", 600);
+    j.at("holditerations").get_to(p.holdIterations);
+    p.priority = j.value("priority", 0);
+    p.coupledSensors =
+        j.value("coupledsensors", std::vector<std::string>{});
 }
 
 Config loadConfig(const std::string& path)
@@ -66,6 +193,39 @@ Config loadConfig(const std::string& path)
             cfg.experiments =
                 j["experiment"].get<std::vector<ExperimentConfig>>();
         }
+
+        // Optional fan-group coupling experiments
+        if (j.contains("mimo") && j["mimo"].is_array())
+        {
+            cfg.mimo = j["mimo"].get<std::vector<MimoConfig>>();
+        }
+
+        // Optional relay-feedback experiments
+        if (j.contains("relay") && j["relay"].is_array())
+        {
+            cfg.relay = j["relay"].get<std::vector<RelayConfig>>();
+        }
+
+        // Optional PRBS / multi-step / staircase experiments
+        if (j.contains("excitation") && j["excitation"].is_array())
+        {
+            cfg.excitation =
+                j["excitation"].get<std::vector<ExcitationConfig>>();
+        }
+
+        // Optional closed-loop validation runs
+        if (j.contains("validation") && j["validation"].is_array())
+        {
+            cfg.validation =
+                j["validation"].get<std::vector<ValidationConfig>>();
+        }
+
+        // Optional sysfs mapping for the hwmon backend
+        if (j.contains("hwmon") && j["hwmon"].is_object())
+        {
+            cfg.hwmonPaths =
+                j["hwmon"].get<std::map<std::string, std::string>>();
+        }
     }
     catch (const json::exception& e)
     {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -9,9 +10,40 @@ namespace autotune::config
 
 struct BasicSetting
 {
-    int pollInterval;
+    double pollInterval; // seconds
     int windowSize;
     int plotSamplingRate;
+    double dbusTimeout; // seconds, per asynchronous D-Bus call
+    double sensorMaxAge; // seconds a PropertiesChanged value is trusted
+    std::string backend; // "dbus" or "hwmon"
+    bool compactStorage; // keep derived sample columns as float32
+    int logFlushBytes;       // batch size of the background log writer
+    double logFlushInterval; // seconds between log writes
+    std::string logFormat;   // "csv" or "binary"
+    bool logDeflate;         // zlib-compress binary sample blocks
+    // End a phase once |slope| and RMSE stay under these for steadyHold
+    // seconds; the iteration counts then act as upper bounds.
+    bool steadyState;
+    double steadySlope; // degC per second
+    double steadyRmse;  // degC
+    double steadyHold;  // seconds
+    // Recursive FOPDT estimate during AfterTriggerWait; optionally end the
+    // phase once every parameter's std dev stays within onlineTolerance
+    // (relative) for onlineHold seconds.
+    bool onlineFopdt;
+    bool onlineStop;
+    double onlineTolerance;
+    double onlineHold;        // seconds
+    double onlineMaxDeadTime; // seconds
+    // Fitter behind the "Optimization" FOPDT estimate: "lm"
+    // (Levenberg-Marquardt) or "neldermead".
+    std::string fopdtSolver;
+    // Extra Latin-hypercube starts for the multi-start FOPDT fit; 0 skips
+    // it.
+    int multiStartSeeds;
+    // Fit FOPDT, SOPDT, IPDT and FOPDT+drift to the step and report the
+    // one with the lowest BIC.
+    bool modelSelection;
 };
 
 struct ExperimentConfig
@@ -23,12 +55,120 @@ struct ExperimentConfig
     int initialIterations;
     int afterTriggerIterations;
     std::string tempSensor;
+    // Every sensor sampled by this experiment: tempSensor first, then any
+    // extra ones listed in "observedsensors".
+    std::vector<std::string> observedSensors;
+    // Scheduling: higher runs first; sensors this experiment's fans disturb.
+    int priority;
+    std::vector<std::string> coupledSensors;
+};
+
+struct FanGroup
+{
+    std::string name;
+    std::vector<std::string> fans;
+};
+
+// Steps each fan group in turn from basePwmDuty to stepPwmDuty while
+// recording every sensor, to identify the sensors x groups coupling.
+struct MimoConfig
+{
+    std::string name;
+    std::vector<FanGroup> fanGroups;
+    double basePwmDuty;
+    double stepPwmDuty;
+    std::vector<std::string> sensors;
+    int settleIterations; // at base duty before the first step
+    int stepInterval;     // between group steps; below hold they overlap
+    int holdIterations;   // after the last step
+    int priority;
+    std::vector<std::string> coupledSensors;
+};
+
+// Relay feedback: switches fans between two duties around a setpoint
+// until the temperature oscillates steadily.
+struct RelayConfig
+{
+    std::string name;
+    std::vector<std::string> fans;
+    std::string tempSensor;
+    double highPwmDuty; // applied above setpoint + hysteresis
+    double lowPwmDuty;  // applied below setpoint - hysteresis
+    std::optional<double> setpoint; // degC; default: mean after settling
+    double hysteresis;              // degC
+    int settleIterations; // at the mid duty before the relay starts
+    int maxIterations;    // upper bound for the relay phase
+    int cycles;           // consistent cycles required to stop
+    double cycleTolerance; // relative spread of period and amplitude
+    int priority;
+    std::vector<std::string> coupledSensors;
+};
+
+// Drives fans with a PRBS, multi-step or staircase duty sequence and fits
+// one model to the whole input/output record.
+struct ExcitationConfig
+{
+    std::string name;
+    std::vector<std::string> fans;
+    std::string tempSensor;
+    std::string signal;         // "prbs", "multistep" or "staircase"
+    double basePwmDuty;         // before and after the sequence
+    std::vector<double> levels; // multistep: duties in order
+    double lowPwmDuty;          // prbs levels / staircase range
+    double highPwmDuty;
+    int stairSteps;       // staircase: steps from low to high and back
+    int prbsOrder;        // prbs: 2^order - 1 bits per period
+    int settleIterations; // at base duty before the sequence
+    int holdIterations;   // per level (per bit for prbs)
+    int tailIterations;   // at base duty after the sequence
+    double imcRatio;      // staircase schedule: IMC epsilon/theta
+    int priority;
+    std::vector<std::string> coupledSensors;
+};
+
+struct FOPDTSpec
+{
+    double k;
+    double tau;
+    double theta;
+};
+
+// Runs a PID loop on one sensor through a setpoint change and scores the
+// response.
+struct ValidationConfig
+{
+    std::string name;
+    std::vector<std::string> fans;
+    std::string tempSensor;
+    double kp; // duty % per degC, error = setpoint - temperature
+    double ki;
+    double kd;
+    std::optional<FOPDTSpec> model; // IMC gains from this instead
+    double imcRatio;
+    double initialPwmDuty; // while settling and afterwards
+    double minPwmDuty;     // controller output limits
+    double maxPwmDuty;
+    std::optional<double> setpoint; // degC
+    double setpointStep;    // degC from the settled temperature otherwise
+    double settleBand;      // degC
+    double maxOvershoot;    // percent, to pass
+    double maxSettlingTime; // seconds, to pass; 0 for no limit
+    int settleIterations;   // at initialPwmDuty before the change
+    int holdIterations;     // closed loop after the change
+    int priority;
+    std::vector<std::string> coupledSensors;
 };
 
 struct Config
 {
     BasicSetting basic;
     std::vector<ExperimentConfig> experiments;
+    std::vector<MimoConfig> mimo;
+    std::vector<RelayConfig> relay;
+    std::vector<ExcitationConfig> excitation;
+    std::vector<ValidationConfig> validation;
+    // Sensor/fan name -> sysfs attribute, used by the hwmon backend.
+    std::map<std::string, std::string> hwmonPaths;
 };
 
 Config loadConfig(const std::string& path);
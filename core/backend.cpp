@@ -0,0 +1,120 @@
+#include "backend.hpp"
+
+#include "hwmon_io.hpp"
+#include "sensor_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace autotune::io
+{
+
+void Backend::readTempsC(const std::vector<std::string>& inputs,
+                         BatchReadHandler handler)
+{
+    struct Batch
+    {
+        std::vector<std::optional<double>> values;
+        std::chrono::steady_clock::time_point completed{};
+        size_t remaining;
+        BatchReadHandler handler;
+    };
+
+    if (inputs.empty())
+    {
+        handler({}, std::chrono::steady_clock::now());
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->values.resize(inputs.size());
+    batch->remaining = inputs.size();
+    batch->handler = std::move(handler);
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        readTempC(inputs[i],
+                  [batch, i](std::optional<double> value,
+                             std::chrono::steady_clock::time_point completed) {
+                      batch->values[i] = value;
+                      batch->completed = std::max(batch->completed, completed);
+                      if (--batch->remaining == 0)
+                          batch->handler(std::move(batch->values),
+                                         batch->completed);
+                  });
+    }
+}
+
+namespace
+{
+
+// Routes through the async D-Bus API and the PropertiesChanged cache.
+class DBusBackend : public Backend
+{
+  public:
+    explicit DBusBackend(const config::BasicSetting& basic) :
+        timeout(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<double>(basic.dbusTimeout))),
+        maxAge(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(basic.sensorMaxAge)))
+    {}
+
+    void readTempC(const std::string& input, ReadHandler handler) override
+    {
+        dbusio::readTempCCached(input, maxAge, std::move(handler), timeout);
+    }
+
+    void readFanPct(const std::string& input, ReadHandler handler) override
+    {
+        dbusio::readFanPctCached(input, maxAge, std::move(handler), timeout);
+    }
+
+    void writePwm(const std::vector<std::string>& inputs, int raw,
+                  WriteHandler handler) override
+    {
+        dbusio::asyncWritePwmAllByInput(inputs, raw, std::move(handler),
+                                        timeout);
+    }
+
+  private:
+    std::chrono::microseconds timeout;
+    std::chrono::steady_clock::duration maxAge;
+};
+
+} // namespace
+
+static std::unique_ptr<Backend>& current()
+{
+    static std::unique_ptr<Backend> b;
+    return b;
+}
+
+std::unique_ptr<Backend> makeBackend(const config::Config& cfg)
+{
+    if (cfg.basic.backend == "hwmon")
+    {
+        std::cerr << "[autotune] Using hwmon sysfs backend ("
+                  << cfg.hwmonPaths.size() << " mapped inputs)\n";
+        return std::make_unique<HwmonBackend>(cfg.hwmonPaths);
+    }
+
+    if (cfg.basic.backend != "dbus")
+    {
+        std::cerr << "[autotune] Unknown backend '" << cfg.basic.backend
+                  << "', falling back to dbus\n";
+    }
+    return std::make_unique<DBusBackend>(cfg.basic);
+}
+
+void setBackend(std::unique_ptr<Backend> b)
+{
+    current() = std::move(b);
+}
+
+Backend& backend()
+{
+    return *current();
+}
+
+} // namespace autotune::io
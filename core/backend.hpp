@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "dbus_io.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::io
+{
+
+using ReadHandler = dbusio::ReadHandler;
+using WriteHandler = dbusio::WriteHandler;
+using WriteResult = dbusio::WriteResult;
+// One value per requested input, in order; completed is the latest of the
+// individual completion times.
+using BatchReadHandler = std::function<void(
+    std::vector<std::optional<double>> values,
+    std::chrono::steady_clock::time_point completed)>;
+
+/**
+ * @brief Sensor/actuator access used by the experiments.
+ *
+ * Handlers run on the service's io_context thread. Implementations may
+ * complete inline when the underlying access does not block.
+ */
+class Backend
+{
+  public:
+    virtual ~Backend() = default;
+
+    virtual void readTempC(const std::string& input, ReadHandler handler) = 0;
+    virtual void readFanPct(const std::string& input, ReadHandler handler) = 0;
+
+    /**
+     * @brief Read several temperatures concurrently and complete once all
+     *        have answered. The default issues readTempC for each input.
+     */
+    virtual void readTempsC(const std::vector<std::string>& inputs,
+                            BatchReadHandler handler);
+
+    virtual void writePwm(const std::vector<std::string>& inputs, int raw,
+                          WriteHandler handler) = 0;
+
+    /**
+     * @brief Hand @p inputs back to whatever controlled them before our
+     *        first writePwm(), once an experiment stops driving them. The
+     *        default does nothing.
+     */
+    virtual void releasePwm(const std::vector<std::string>& inputs)
+    {
+        (void)inputs;
+    }
+};
+
+/**
+ * @brief Build the backend selected by basicsetting "backend":
+ *        "dbus" (default) or "hwmon".
+ */
+std::unique_ptr<Backend> makeBackend(const config::Config& cfg);
+
+/** Install the process-wide backend used by experiments. */
+void setBackend(std::unique_ptr<Backend> b);
+
+/** Current backend; must be set before experiments start. */
+Backend& backend();
+
+} // namespace autotune::io
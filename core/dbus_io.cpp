@@ -2,7 +2,9 @@
 
 #include "../dbus/constants.hpp"
 
+#include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/exception.hpp>
 #include <sdbusplus/message.hpp>
 
@@ -10,7 +12,10 @@
 #include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -23,10 +28,78 @@ static sdbusplus::bus_t& bus()
     return b;
 }
 
-// Resolve owning service (path, interface) via ObjectMapper.GetObject.
+// Connection shared with main's io_context, used by the async API.
+static std::shared_ptr<sdbusplus::asio::connection>& asyncConn()
+{
+    static std::shared_ptr<sdbusplus::asio::connection> c;
+    return c;
+}
+
+std::optional<double> toDouble(const PropertyVariant& v)
+{
+    if (auto pd = std::get_if<double>(&v))
+        return *pd;
+    if (auto pi = std::get_if<int64_t>(&v))
+        return static_cast<double>(*pi);
+    if (auto pu = std::get_if<uint64_t>(&v))
+        return static_cast<double>(*pu);
+    return std::nullopt;
+}
+
+// (path, interface) -> owning service, filled lazily by getService() and
+// up front by prewarmServiceCache(). Entries are dropped by the signal
+// matches installed in watchServiceChanges().
+using ServiceKey = std::pair<std::string, std::string>;
+
+static std::map<ServiceKey, std::string>& serviceCache()
+{
+    static std::map<ServiceKey, std::string> cache;
+    return cache;
+}
+
+static void dropService(const std::string& path, const std::string& iface)
+{
+    serviceCache().erase({path, iface});
+}
+
+static void dropPath(const std::string& path)
+{
+    auto& cache = serviceCache();
+    auto it = cache.lower_bound({path, ""});
+    while (it != cache.end() && it->first.first == path)
+        it = cache.erase(it);
+}
+
+static void dropOwner(const std::string& service)
+{
+    std::erase_if(serviceCache(),
+                  [&](const auto& kv) { return kv.second == service; });
+}
+
+static std::string tempPath(const std::string& input)
+{
+    return autotune::dbusconst::kTempSensorRoot + input;
+}
+
+static std::string fanSensorPath(const std::string& input)
+{
+    return autotune::dbusconst::kFanPwmSensorRoot + input;
+}
+
+static std::string fanControlPath(const std::string& input)
+{
+    return autotune::dbusconst::kFanPwmControlRoot + input;
+}
+
+// Resolve owning service (path, interface) via ObjectMapper.GetObject,
+// consulting the cache first.
 static std::optional<std::string> getService(const std::string& path,
                                              const std::string& iface)
 {
+    auto& cache = serviceCache();
+    if (auto it = cache.find({path, iface}); it != cache.end())
+        return it->second;
+
     try
     {
         auto m = bus().new_method_call(
@@ -44,6 +117,7 @@ static std::optional<std::string> getService(const std::string& path,
         if (owners.empty())
             return std::nullopt;
 
+        cache[{path, iface}] = owners.begin()->first;
         return owners.begin()->first;
     }
     catch (const sdbusplus::exception_t& e)
@@ -69,18 +143,13 @@ static std::optional<double> getDouble(
                                   autotune::dbusconst::kPropertiesIface, "Get");
         m.append(iface, prop);
 
-        using V = std::variant<double, int64_t, uint64_t, bool, std::string>;
-        V v;
+        PropertyVariant v;
         auto reply = bus().call(m);
         reply.read(v);
 
-        if (auto pd = std::get_if<double>(&v))
-            return *pd;
-        if (auto pi = std::get_if<int64_t>(&v))
-            return static_cast<double>(*pi);
-        if (auto pu = std::get_if<uint64_t>(&v))
-            return static_cast<double>(*pu);
-        
+        if (auto d = toDouble(v))
+            return d;
+
         // Sometimes it might find bool or string, which we can't cast to double easily or don't want to
         std::cerr << "[autotune] Get " << path << " " << iface << "." << prop
                   << " not numeric\n";
@@ -90,6 +159,7 @@ static std::optional<double> getDouble(
     {
         std::cerr << "[autotune] Properties.Get failed for " << path << " "
                   << iface << "." << prop << ": " << e.what() << "\n";
+        dropService(path, iface);
         return std::nullopt;
     }
 }
@@ -115,43 +185,346 @@ static bool setUint64(const std::string& path, const std::string& iface,
     {
         std::cerr << "[autotune] Properties.Set failed for " << path << " "
                   << iface << "." << prop << ": " << e.what() << "\n";
+        dropService(path, iface);
         return false;
     }
 }
 
 double readTempCByInput(const std::string& input)
 {
-    const std::string path =
-        "/xyz/openbmc_project/sensors/temperature/" + input;
-    const std::string iface = "xyz.openbmc_project.Sensor.Value";
-    const std::string prop = "Value";
-    auto v = getDouble(path, iface, prop);
+    auto v = getDouble(tempPath(input), autotune::dbusconst::kSensorValueIface,
+                       "Value");
     return v.value_or(0.0);
 }
 
 bool writePwmAllByInput(const std::vector<std::string>& inputs, int raw)
 {
     const uint64_t u = static_cast<uint64_t>(std::clamp(raw, 0, 255));
-    const std::string iface = "xyz.openbmc_project.Control.FanPwm";
-    const std::string prop = "Target";
 
     bool ok = true;
     for (const auto& in : inputs)
     {
-        const std::string path = "/xyz/openbmc_project/control/fanpwm/" + in;
-        ok = setUint64(path, iface, prop, u) && ok;
+        ok = setUint64(fanControlPath(in), autotune::dbusconst::kFanPwmIface,
+                       "Target", u) &&
+             ok;
     }
     return ok;
 }
 
 std::optional<double> readFanPctByInput(const std::string& input)
 {
-    const std::string path = "/xyz/openbmc_project/sensors/fan_pwm/" + input;
-    const std::string iface = "xyz.openbmc_project.Sensor.Value";
-    const std::string prop = "Value";
-    return getDouble(path, iface, prop);
+    return getDouble(fanSensorPath(input),
+                     autotune::dbusconst::kSensorValueIface, "Value");
+}
+
+// ---- Asynchronous API -------------------------------------------------
+
+using ServiceHandler = std::function<void(std::optional<std::string>)>;
+
+// Async counterpart of getService(): cache hit completes immediately,
+// otherwise Mapper.GetObject is issued on the shared connection.
+static void asyncGetService(const std::string& path, const std::string& iface,
+                            std::chrono::microseconds timeout,
+                            ServiceHandler handler)
+{
+    if (auto it = serviceCache().find({path, iface});
+        it != serviceCache().end())
+    {
+        handler(it->second);
+        return;
+    }
+
+    asyncConn()->async_method_call_timed(
+        [path, iface, handler = std::move(handler)](
+            const boost::system::error_code& ec,
+            const std::map<std::string, std::vector<std::string>>& owners) {
+            if (ec || owners.empty())
+            {
+                std::cerr << "[autotune] Mapper.GetObject failed for " << path
+                          << " iface=" << iface << ": " << ec.message()
+                          << "\n";
+                handler(std::nullopt);
+                return;
+            }
+            serviceCache()[{path, iface}] = owners.begin()->first;
+            handler(owners.begin()->first);
+        },
+        autotune::dbusconst::kMapperService, autotune::dbusconst::kMapperPath,
+        autotune::dbusconst::kMapperIface, "GetObject", timeout.count(), path,
+        std::vector<std::string>{iface});
+}
+
+static void asyncGetDouble(const std::string& path, const std::string& iface,
+                           const std::string& prop,
+                           std::chrono::microseconds timeout,
+                           ReadHandler handler)
+{
+    asyncGetService(
+        path, iface, timeout,
+        [path, iface, prop, timeout,
+         handler = std::move(handler)](std::optional<std::string> svc) {
+            if (!svc)
+            {
+                handler(std::nullopt, std::chrono::steady_clock::now());
+                return;
+            }
+
+            asyncConn()->async_method_call_timed(
+                [path, iface, prop, handler](const boost::system::error_code& ec,
+                                             const PropertyVariant& v) {
+                    auto completed = std::chrono::steady_clock::now();
+                    if (ec)
+                    {
+                        std::cerr << "[autotune] Properties.Get failed for "
+                                  << path << " " << iface << "." << prop
+                                  << ": " << ec.message() << "\n";
+                        dropService(path, iface);
+                        handler(std::nullopt, completed);
+                        return;
+                    }
+
+                    auto d = toDouble(v);
+                    if (!d)
+                    {
+                        std::cerr << "[autotune] Get " << path << " " << iface
+                                  << "." << prop << " not numeric\n";
+                    }
+                    handler(d, completed);
+                },
+                *svc, path, autotune::dbusconst::kPropertiesIface, "Get",
+                timeout.count(), iface, prop);
+        });
 }
 
+using SetHandler = std::function<void(bool ok)>;
 
+static void asyncSetUint64(const std::string& path, const std::string& iface,
+                           const std::string& prop, uint64_t val,
+                           std::chrono::microseconds timeout,
+                           SetHandler handler)
+{
+    asyncGetService(
+        path, iface, timeout,
+        [path, iface, prop, val, timeout,
+         handler = std::move(handler)](std::optional<std::string> svc) {
+            if (!svc)
+            {
+                handler(false);
+                return;
+            }
+
+            asyncConn()->async_method_call_timed(
+                [path, iface, prop,
+                 handler](const boost::system::error_code& ec) {
+                    if (ec)
+                    {
+                        std::cerr << "[autotune] Properties.Set failed for "
+                                  << path << " " << iface << "." << prop
+                                  << ": " << ec.message() << "\n";
+                        dropService(path, iface);
+                    }
+                    handler(!ec);
+                },
+                *svc, path, autotune::dbusconst::kPropertiesIface, "Set",
+                timeout.count(), iface, prop, std::variant<uint64_t>(val));
+        });
+}
+
+// Fails the call up front when setConnection() has not been called.
+static bool requireConnection(const std::function<void()>& fail)
+{
+    if (asyncConn())
+        return true;
+    std::cerr << "[autotune] Async D-Bus call before setConnection()\n";
+    fail();
+    return false;
+}
+
+void setConnection(std::shared_ptr<sdbusplus::asio::connection> conn)
+{
+    asyncConn() = std::move(conn);
+}
+
+void asyncReadTempCByInput(const std::string& input, ReadHandler handler,
+                           std::chrono::microseconds timeout)
+{
+    if (!requireConnection([&] {
+            handler(std::nullopt, std::chrono::steady_clock::now());
+        }))
+        return;
+    asyncGetDouble(tempPath(input), autotune::dbusconst::kSensorValueIface,
+                   "Value", timeout, std::move(handler));
+}
+
+void asyncReadFanPctByInput(const std::string& input, ReadHandler handler,
+                            std::chrono::microseconds timeout)
+{
+    if (!requireConnection([&] {
+            handler(std::nullopt, std::chrono::steady_clock::now());
+        }))
+        return;
+    asyncGetDouble(fanSensorPath(input), autotune::dbusconst::kSensorValueIface,
+                   "Value", timeout, std::move(handler));
+}
+
+void asyncWritePwmAllByInput(const std::vector<std::string>& inputs, int raw,
+                             WriteHandler handler,
+                             std::chrono::microseconds timeout)
+{
+    if (!requireConnection([&] {
+            auto now = std::chrono::steady_clock::now();
+            handler(WriteResult{false, now, now});
+        }))
+        return;
+
+    // Shared by every per-fan completion; the last one reports.
+    struct FanOut
+    {
+        size_t pending = 0;
+        WriteResult result;
+        WriteHandler handler;
+    };
+
+    auto fanOut = std::make_shared<FanOut>();
+    fanOut->pending = inputs.size();
+    fanOut->handler = std::move(handler);
+    fanOut->result.issued = std::chrono::steady_clock::now();
+    fanOut->result.acked = fanOut->result.issued;
+
+    if (inputs.empty())
+    {
+        fanOut->handler(fanOut->result);
+        return;
+    }
+
+    const uint64_t u = static_cast<uint64_t>(std::clamp(raw, 0, 255));
+    for (const auto& in : inputs)
+    {
+        asyncSetUint64(fanControlPath(in), autotune::dbusconst::kFanPwmIface,
+                       "Target", u, timeout, [fanOut](bool r) {
+                           fanOut->result.ok = r && fanOut->result.ok;
+                           fanOut->result.acked =
+                               std::chrono::steady_clock::now();
+                           if (--fanOut->pending == 0)
+                               fanOut->handler(fanOut->result);
+                       });
+    }
+}
+
+void prewarmServiceCache(const std::vector<std::string>& tempInputs,
+                         const std::vector<std::string>& fanInputs)
+{
+    // Every (path, interface) pair the experiments will touch.
+    std::set<ServiceKey> wanted;
+    for (const auto& in : tempInputs)
+        wanted.emplace(tempPath(in), autotune::dbusconst::kSensorValueIface);
+    for (const auto& in : fanInputs)
+    {
+        wanted.emplace(fanSensorPath(in),
+                       autotune::dbusconst::kSensorValueIface);
+        wanted.emplace(fanControlPath(in), autotune::dbusconst::kFanPwmIface);
+    }
+
+    if (wanted.empty())
+        return;
+
+    using SubTree = std::map<std::string,
+                             std::map<std::string, std::vector<std::string>>>;
+    SubTree tree;
+    try
+    {
+        auto m = bus().new_method_call(
+            autotune::dbusconst::kMapperService,
+            autotune::dbusconst::kMapperPath, autotune::dbusconst::kMapperIface,
+            "GetSubTree");
+
+        std::vector<std::string> ifaces = {
+            autotune::dbusconst::kSensorValueIface,
+            autotune::dbusconst::kFanPwmIface};
+        m.append(autotune::dbusconst::kObjectRoot, int32_t{0}, ifaces);
+
+        auto reply = bus().call(m);
+        reply.read(tree);
+    }
+    catch (const sdbusplus::exception_t& e)
+    {
+        std::cerr << "[autotune] Mapper.GetSubTree failed: " << e.what()
+                  << "\n";
+        return;
+    }
+
+    size_t resolved = 0;
+    for (const auto& [path, owners] : tree)
+    {
+        for (const auto& [service, ifaces] : owners)
+        {
+            for (const auto& iface : ifaces)
+            {
+                ServiceKey key{path, iface};
+                if (!wanted.contains(key) || serviceCache().contains(key))
+                    continue;
+                serviceCache()[key] = service;
+                resolved++;
+            }
+        }
+    }
+
+    std::cerr << "[autotune] Service cache prewarmed: " << resolved << "/"
+              << wanted.size() << " objects resolved\n";
+}
+
+void watchServiceChanges(sdbusplus::bus_t& b)
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    static std::vector<std::unique_ptr<sdbusplus::bus::match_t>> matches;
+    if (!matches.empty())
+        return;
+
+    matches.emplace_back(std::make_unique<sdbusplus::bus::match_t>(
+        b, rules::nameOwnerChanged(), [](sdbusplus::message_t& msg) {
+            std::string name, oldOwner, newOwner;
+            try
+            {
+                msg.read(name, oldOwner, newOwner);
+            }
+            catch (const sdbusplus::exception_t&)
+            {
+                return;
+            }
+            if (!oldOwner.empty())
+                dropOwner(name);
+        }));
+
+    matches.emplace_back(std::make_unique<sdbusplus::bus::match_t>(
+        b, rules::interfacesAdded(), [](sdbusplus::message_t& msg) {
+            sdbusplus::message::object_path path;
+            try
+            {
+                msg.read(path);
+            }
+            catch (const sdbusplus::exception_t&)
+            {
+                return;
+            }
+            dropPath(path.str);
+        }));
+
+    matches.emplace_back(std::make_unique<sdbusplus::bus::match_t>(
+        b, rules::interfacesRemoved(), [](sdbusplus::message_t& msg) {
+            sdbusplus::message::object_path path;
+            std::vector<std::string> ifaces;
+            try
+            {
+                msg.read(path, ifaces);
+            }
+            catch (const sdbusplus::exception_t&)
+            {
+                return;
+            }
+            for (const auto& iface : ifaces)
+                dropService(path.str, iface);
+        }));
+}
 
 } // namespace autotune::dbusio
@@ -1,14 +1,85 @@
 #pragma once
 
+#include <sdbusplus/asio/connection.hpp>
+#include <sdbusplus/bus.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <variant>
 #include <vector>
 
 namespace autotune::dbusio
 {
 
+/** Property value types accepted for numeric sensor properties. */
+using PropertyVariant =
+    std::variant<double, int64_t, uint64_t, bool, std::string>;
+
+/** Numeric value of @p v, or std::nullopt for bool/string. */
+std::optional<double> toDouble(const PropertyVariant& v);
+
 double readTempCByInput(const std::string& input);
 bool writePwmAllByInput(const std::vector<std::string>& inputs, int raw);
 std::optional<double> readFanPctByInput(const std::string& input);
 
+/**
+ * @brief Completion of an asynchronous read.
+ * @param value Reading, or std::nullopt if resolution or the call failed
+ * @param completed Time the reply (or error) was received
+ */
+using ReadHandler =
+    std::function<void(std::optional<double> value,
+                       std::chrono::steady_clock::time_point completed)>;
+
+/**
+ * @brief Outcome of an asynchronous PWM write across a set of fans.
+ */
+struct WriteResult
+{
+    bool ok = true; // every fan accepted the new target
+    std::chrono::steady_clock::time_point issued; // first Set sent
+    std::chrono::steady_clock::time_point acked;  // last reply received
+};
+
+using WriteHandler = std::function<void(const WriteResult& result)>;
+
+constexpr std::chrono::microseconds kDefaultTimeout = std::chrono::seconds(1);
+
+/**
+ * @brief Set the connection used by the async API. Must be called before
+ *        any async* function; handlers run on that connection's io_context.
+ */
+void setConnection(std::shared_ptr<sdbusplus::asio::connection> conn);
+
+void asyncReadTempCByInput(const std::string& input, ReadHandler handler,
+                           std::chrono::microseconds timeout = kDefaultTimeout);
+void asyncReadFanPctByInput(
+    const std::string& input, ReadHandler handler,
+    std::chrono::microseconds timeout = kDefaultTimeout);
+/**
+ * @brief Set Target on every fan concurrently and complete once all of them
+ *        have replied, reporting the issue/acknowledge window.
+ */
+void asyncWritePwmAllByInput(
+    const std::vector<std::string>& inputs, int raw, WriteHandler handler,
+    std::chrono::microseconds timeout = kDefaultTimeout);
+
+/**
+ * @brief Resolve the owning services of the given sensors and fans with a
+ *        single ObjectMapper.GetSubTree call and seed the service cache.
+ * @param tempInputs Temperature sensor names (e.g. CPU0_TEMP)
+ * @param fanInputs Fan PWM names (e.g. PWM_DUTY0)
+ */
+void prewarmServiceCache(const std::vector<std::string>& tempInputs,
+                         const std::vector<std::string>& fanInputs);
+
+/**
+ * @brief Drop cached service entries on NameOwnerChanged and
+ *        InterfacesAdded/InterfacesRemoved signals seen on @p bus.
+ */
+void watchServiceChanges(sdbusplus::bus_t& bus);
+
 } // namespace autotune::dbusio
@@ -0,0 +1,226 @@
+#include "hwmon_io.hpp"
+
+#include "utils.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace autotune::io
+{
+
+// pwmN attributes are written as well as read; everything else is input.
+static bool isPwm(const std::string& path)
+{
+    auto slash = path.find_last_of('/');
+    std::string name =
+        (slash == std::string::npos) ? path : path.substr(slash + 1);
+    return name.starts_with("pwm") &&
+           name.find_first_not_of("0123456789", 3) == std::string::npos;
+}
+
+HwmonBackend::HwmonBackend(const std::map<std::string, std::string>& paths)
+{
+    for (const auto& [name, path] : paths)
+        attrs[name].path = path;
+}
+
+HwmonBackend::~HwmonBackend()
+{
+    for (auto& [name, attr] : attrs)
+    {
+        restoreMode(attr);
+        if (attr.fd >= 0)
+            ::close(attr.fd);
+    }
+}
+
+int HwmonBackend::openAttr(Attr& attr)
+{
+    if (attr.fd >= 0)
+        return attr.fd;
+
+    bool pwm = isPwm(attr.path);
+    attr.fd = ::open(attr.path.c_str(), (pwm ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (attr.fd < 0)
+    {
+        std::cerr << "[autotune] open " << attr.path
+                  << " failed: " << std::strerror(errno) << "\n";
+        return -1;
+    }
+    return attr.fd;
+}
+
+// Manual mode, otherwise the driver may ignore or override our writes.
+void HwmonBackend::takeManual(Attr& attr)
+{
+    if (attr.manual || !isPwm(attr.path))
+        return;
+    attr.manual = true;
+
+    std::string enable = attr.path + "_enable";
+    int efd = ::open(enable.c_str(), O_RDWR | O_CLOEXEC);
+    if (efd < 0)
+        return; // no mode control; the driver takes every write
+
+    char buf[16];
+    ssize_t n = ::pread(efd, buf, sizeof(buf) - 1, 0);
+    if (n > 0)
+    {
+        buf[n] = '\0';
+        std::string mode(buf, std::strcspn(buf, "\n"));
+        if (mode != "1")
+            attr.savedEnable = mode;
+    }
+    else
+    {
+        std::cerr << "[autotune] read " << enable
+                  << " failed, it will not be restored\n";
+    }
+
+    if (n <= 0 || !attr.savedEnable.empty())
+    {
+        if (::pwrite(efd, "1", 1, 0) < 0)
+        {
+            std::cerr << "[autotune] write " << enable
+                      << " failed: " << std::strerror(errno) << "\n";
+        }
+    }
+    ::close(efd);
+}
+
+void HwmonBackend::restoreMode(Attr& attr)
+{
+    attr.manual = false;
+    if (attr.savedEnable.empty())
+        return;
+
+    std::string enable = attr.path + "_enable";
+    int efd = ::open(enable.c_str(), O_WRONLY | O_CLOEXEC);
+    if (efd < 0 || ::pwrite(efd, attr.savedEnable.data(),
+                            attr.savedEnable.size(), 0) < 0)
+    {
+        std::cerr << "[autotune] restore " << enable << "="
+                  << attr.savedEnable << " failed: " << std::strerror(errno)
+                  << "\n";
+    }
+    if (efd >= 0)
+        ::close(efd);
+    attr.savedEnable.clear();
+}
+
+std::optional<long> HwmonBackend::readLong(const std::string& input)
+{
+    auto it = attrs.find(input);
+    if (it == attrs.end())
+    {
+        std::cerr << "[autotune] No hwmon path configured for " << input
+                  << "\n";
+        return std::nullopt;
+    }
+
+    int fd = openAttr(it->second);
+    if (fd < 0)
+        return std::nullopt;
+
+    char buf[32];
+    ssize_t n = ::pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0)
+    {
+        std::cerr << "[autotune] read " << it->second.path
+                  << " failed: " << std::strerror(errno) << "\n";
+        // The device may have gone away; reopen on the next access.
+        ::close(fd);
+        it->second.fd = -1;
+        return std::nullopt;
+    }
+    buf[n] = '\0';
+
+    char* end = nullptr;
+    long v = std::strtol(buf, &end, 10);
+    if (end == buf)
+        return std::nullopt;
+    return v;
+}
+
+bool HwmonBackend::writeLong(const std::string& input, long value)
+{
+    auto it = attrs.find(input);
+    if (it == attrs.end())
+    {
+        std::cerr << "[autotune] No hwmon path configured for " << input
+                  << "\n";
+        return false;
+    }
+
+    int fd = openAttr(it->second);
+    if (fd < 0)
+        return false;
+    takeManual(it->second);
+
+    std::string s = std::to_string(value);
+    if (::pwrite(fd, s.data(), s.size(), 0) != static_cast<ssize_t>(s.size()))
+    {
+        std::cerr << "[autotune] write " << it->second.path
+                  << " failed: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        it->second.fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void HwmonBackend::readTempC(const std::string& input, ReadHandler handler)
+{
+    // tempN_input is in millidegrees Celsius.
+    auto v = readLong(input);
+    auto now = std::chrono::steady_clock::now();
+    if (!v)
+    {
+        handler(std::nullopt, now);
+        return;
+    }
+    handler(static_cast<double>(*v) / 1000.0, now);
+}
+
+void HwmonBackend::readFanPct(const std::string& input, ReadHandler handler)
+{
+    auto v = readLong(input);
+    auto now = std::chrono::steady_clock::now();
+    if (!v)
+    {
+        handler(std::nullopt, now);
+        return;
+    }
+    handler(core::scaleRawToDuty(static_cast<int>(*v)), now);
+}
+
+void HwmonBackend::writePwm(const std::vector<std::string>& inputs, int raw,
+                            WriteHandler handler)
+{
+    WriteResult result;
+    result.issued = std::chrono::steady_clock::now();
+    long value = std::clamp(raw, 0, 255);
+    for (const auto& in : inputs)
+        result.ok = writeLong(in, value) && result.ok;
+    result.acked = std::chrono::steady_clock::now();
+    handler(result);
+}
+
+void HwmonBackend::releasePwm(const std::vector<std::string>& inputs)
+{
+    for (const auto& in : inputs)
+    {
+        auto it = attrs.find(in);
+        if (it != attrs.end())
+            restoreMode(it->second);
+    }
+}
+
+} // namespace autotune::io
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "backend.hpp"
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::io
+{
+
+/**
+ * @brief Backend that reads tempN_input and writes pwmN directly under
+ *        /sys/class/hwmon.
+ *
+ * Each mapped attribute is opened once and kept open; every sample is a
+ * single pread()/pwrite() at offset 0, so polling well below a second adds
+ * no D-Bus traffic. Temperatures are reported in degrees C, fan readings
+ * in percent duty. The first write to a pwmN switches pwmN_enable to
+ * manual; releasePwm() and the destructor put the previous mode back so
+ * the platform's thermal control takes the fan over again.
+ */
+class HwmonBackend : public Backend
+{
+  public:
+    /**
+     * @param paths Sensor/fan name -> sysfs attribute, e.g.
+     *        "CPU0_TEMP" -> "/sys/class/hwmon/hwmon3/temp1_input",
+     *        "PWM_DUTY0" -> "/sys/class/hwmon/hwmon2/pwm1"
+     */
+    explicit HwmonBackend(const std::map<std::string, std::string>& paths);
+    ~HwmonBackend() override;
+
+    HwmonBackend(const HwmonBackend&) = delete;
+    HwmonBackend& operator=(const HwmonBackend&) = delete;
+
+    void readTempC(const std::string& input, ReadHandler handler) override;
+    void readFanPct(const std::string& input, ReadHandler handler) override;
+    void writePwm(const std::vector<std::string>& inputs, int raw,
+                  WriteHandler handler) override;
+
+    /** Restore each pwmN_enable to its value before our first write. */
+    void releasePwm(const std::vector<std::string>& inputs) override;
+
+  private:
+    struct Attr
+    {
+        std::string path;
+        int fd = -1;
+        // pwmN_enable was switched to manual by us.
+        bool manual = false;
+        // Its previous value, written back on release; empty if it was
+        // already manual or could not be read.
+        std::string savedEnable;
+    };
+
+    static int openAttr(Attr& attr);
+    static void takeManual(Attr& attr);
+    static void restoreMode(Attr& attr);
+    std::optional<long> readLong(const std::string& input);
+    bool writeLong(const std::string& input, long value);
+
+    std::map<std::string, Attr> attrs;
+};
+
+} // namespace autotune::io
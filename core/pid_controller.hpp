@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+
+namespace autotune::core
+{
+
+/**
+ * @brief Discrete parallel-form PID, error = setpoint - measurement.
+ *
+ * The derivative acts on the measurement so a setpoint change does not
+ * kick the output, and the integral is held while the output is saturated
+ * in the direction the error would push it (anti-windup).
+ */
+class PIDController
+{
+  public:
+    PIDController(double kp, double ki, double kd, double outMin,
+                  double outMax) :
+        kp(kp), ki(ki), kd(kd), outMin(outMin), outMax(outMax)
+    {}
+
+    /** Bumpless start: the first update returns about @p output. */
+    void reset(double output, double measurement)
+    {
+        integral = std::clamp(output, outMin, outMax);
+        lastMeasurement = measurement;
+    }
+
+    double update(double setpoint, double measurement, double dt)
+    {
+        double error = setpoint - measurement;
+        double derivative =
+            dt > 0 ? -(measurement - lastMeasurement) / dt : 0.0;
+        lastMeasurement = measurement;
+
+        double candidate = integral + ki * error * dt;
+        double out = kp * error + candidate + kd * derivative;
+        bool pushingHigh = out > outMax && ki * error > 0;
+        bool pushingLow = out < outMin && ki * error < 0;
+        if (!pushingHigh && !pushingLow)
+            integral = candidate;
+
+        out = kp * error + integral + kd * derivative;
+        return std::clamp(out, outMin, outMax);
+    }
+
+  private:
+    double kp;
+    double ki;
+    double kd;
+    double outMin;
+    double outMax;
+    double integral = 0.0;
+    double lastMeasurement = 0.0;
+};
+
+} // namespace autotune::core
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace autotune::core
+{
+
+/**
+ * @brief Fixed-capacity ring buffer. Storage is allocated once; push()
+ *        overwrites the oldest element when full.
+ */
+template <typename T>
+class RingBuffer
+{
+  public:
+    explicit RingBuffer(size_t capacity) : buf(std::max<size_t>(capacity, 1))
+    {}
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+    void push(const T& v)
+    {
+        buf[(head + count) % buf.size()] = v;
+        if (count < buf.size())
+            count++;
+        else
+            head = (head + 1) % buf.size();
+    }
+
+    /** Element @p i counted from the oldest. */
+    const T& operator[](size_t i) const
+    {
+        return buf[(head + i) % buf.size()];
+    }
+
+    const T& front() const
+    {
+        return (*this)[0];
+    }
+
+    const T& back() const
+    {
+        return (*this)[count - 1];
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    size_t capacity() const
+    {
+        return buf.size();
+    }
+
+    bool full() const
+    {
+        return count == buf.size();
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+  private:
+    std::vector<T> buf;
+    size_t head = 0;
+    size_t count = 0;
+};
+
+/**
+ * @brief Neumaier-compensated running sum.
+ */
+class CompensatedSum
+{
+  public:
+    void add(double x)
+    {
+        double t = sum + x;
+        if (std::abs(sum) >= std::abs(x))
+            comp += (sum - t) + x;
+        else
+            comp += (x - t) + sum;
+        sum = t;
+    }
+
+    void reset(double v = 0.0)
+    {
+        sum = v;
+        comp = 0.0;
+    }
+
+    double value() const
+    {
+        return sum + comp;
+    }
+
+  private:
+    double sum = 0.0;
+    double comp = 0.0;
+};
+
+/**
+ * @brief Slope, mean and RMSE over the last N (time, value) samples,
+ *        updated in O(1) per sample without allocating.
+ *
+ * Matches calculateSlope/calculateMean/calculateRMSE on the same window:
+ * every statistic reads 0 until the window is full. Sums are kept
+ * relative to a reference point that is moved to the oldest sample each
+ * time the window turns over, so long runs do not lose precision to
+ * large timestamps.
+ */
+class RollingStats
+{
+  public:
+    explicit RollingStats(size_t windowSize) : window(windowSize) {}
+
+    void reset()
+    {
+        window.clear();
+        sumX.reset();
+        sumY.reset();
+        sumXY.reset();
+        sumX2.reset();
+        sumY2.reset();
+        refX = 0.0;
+        refY = 0.0;
+        sinceRecenter = 0;
+    }
+
+    void push(double time, double value)
+    {
+        if (window.empty())
+        {
+            refX = time;
+            refY = value;
+        }
+
+        if (window.full())
+        {
+            const Sample& old = window.front();
+            double ox = old.time - refX;
+            double oy = old.value - refY;
+            sumX.add(-ox);
+            sumY.add(-oy);
+            sumXY.add(-ox * oy);
+            sumX2.add(-ox * ox);
+            sumY2.add(-oy * oy);
+        }
+
+        window.push({time, value});
+
+        double x = time - refX;
+        double y = value - refY;
+        sumX.add(x);
+        sumY.add(y);
+        sumXY.add(x * y);
+        sumX2.add(x * x);
+        sumY2.add(y * y);
+
+        if (++sinceRecenter >= window.capacity())
+            recenter();
+    }
+
+    bool full() const
+    {
+        return window.full();
+    }
+
+    size_t size() const
+    {
+        return window.size();
+    }
+
+    /** Least-squares slope of value over time. */
+    double slope() const
+    {
+        if (!window.full() || window.size() < 2)
+            return 0.0;
+
+        double n = static_cast<double>(window.size());
+        double sx = sumX.value();
+        double denominator = n * sumX2.value() - sx * sx;
+        return (std::abs(denominator) < 1e-6)
+                   ? 0.0
+                   : ((n * sumXY.value() - sx * sumY.value()) / denominator);
+    }
+
+    double mean() const
+    {
+        if (!window.full())
+            return 0.0;
+        return refY + sumY.value() / static_cast<double>(window.size());
+    }
+
+    /** Root-mean-square deviation from the window mean. */
+    double rmse() const
+    {
+        if (!window.full())
+            return 0.0;
+
+        double n = static_cast<double>(window.size());
+        double m = sumY.value() / n;
+        return std::sqrt(std::max(sumY2.value() / n - m * m, 0.0));
+    }
+
+  private:
+    struct Sample
+    {
+        double time;
+        double value;
+    };
+
+    // Shift the reference point to the oldest sample. The sums are
+    // translated algebraically, so this stays O(1).
+    void recenter()
+    {
+        sinceRecenter = 0;
+        const Sample& first = window.front();
+        double dx = first.time - refX;
+        double dy = first.value - refY;
+        if (dx == 0.0 && dy == 0.0)
+            return;
+
+        double n = static_cast<double>(window.size());
+        double sx = sumX.value();
+        double sy = sumY.value();
+        double sxy = sumXY.value();
+        double sx2 = sumX2.value();
+        double sy2 = sumY2.value();
+
+        sumX.reset(sx - n * dx);
+        sumY.reset(sy - n * dy);
+        sumXY.reset(sxy - dy * sx - dx * sy + n * dx * dy);
+        sumX2.reset(sx2 - 2.0 * dx * sx + n * dx * dx);
+        sumY2.reset(sy2 - 2.0 * dy * sy + n * dy * dy);
+
+        refX = first.time;
+        refY = first.value;
+    }
+
+    RingBuffer<Sample> window;
+    CompensatedSum sumX;
+    CompensatedSum sumY;
+    CompensatedSum sumXY;
+    CompensatedSum sumX2;
+    CompensatedSum sumY2;
+    double refX = 0.0;
+    double refY = 0.0;
+    size_t sinceRecenter = 0;
+};
+
+} // namespace autotune::core
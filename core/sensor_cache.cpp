@@ -0,0 +1,144 @@
+#include "sensor_cache.hpp"
+
+#include "../dbus/constants.hpp"
+
+#include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message.hpp>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autotune::dbusio
+{
+
+// Sensor object path -> last value and when it was seen.
+static std::map<std::string, CachedValue>& valueCache()
+{
+    static std::map<std::string, CachedValue> cache;
+    return cache;
+}
+
+static std::map<std::string, std::unique_ptr<sdbusplus::bus::match_t>>&
+    matches()
+{
+    static std::map<std::string, std::unique_ptr<sdbusplus::bus::match_t>> m;
+    return m;
+}
+
+static void store(const std::string& path, double value,
+                  std::chrono::steady_clock::time_point when)
+{
+    valueCache()[path] = CachedValue{value, when};
+}
+
+static void subscribe(sdbusplus::bus_t& bus, const std::string& path)
+{
+    if (matches().contains(path))
+        return;
+
+    matches().emplace(
+        path,
+        std::make_unique<sdbusplus::bus::match_t>(
+            bus,
+            sdbusplus::bus::match::rules::propertiesChanged(
+                path, autotune::dbusconst::kSensorValueIface),
+            [path](sdbusplus::message_t& msg) {
+                std::string iface;
+                std::map<std::string, PropertyVariant> changed;
+                try
+                {
+                    msg.read(iface, changed);
+                }
+                catch (const sdbusplus::exception_t& e)
+                {
+                    std::cerr << "[autotune] Bad PropertiesChanged from "
+                              << path << ": " << e.what() << "\n";
+                    return;
+                }
+
+                auto it = changed.find("Value");
+                if (it == changed.end())
+                    return;
+                if (auto d = toDouble(it->second))
+                    store(path, *d, std::chrono::steady_clock::now());
+            }));
+}
+
+static std::optional<CachedValue> lookup(const std::string& path)
+{
+    auto it = valueCache().find(path);
+    if (it == valueCache().end())
+        return std::nullopt;
+    return it->second;
+}
+
+using AsyncRead = void (*)(const std::string&, ReadHandler,
+                           std::chrono::microseconds);
+
+static void readCached(const std::string& path, const std::string& input,
+                       std::chrono::steady_clock::duration maxAge,
+                       ReadHandler handler, std::chrono::microseconds timeout,
+                       AsyncRead fallback)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (auto v = lookup(path); v && now - v->updated <= maxAge)
+    {
+        handler(v->value, now);
+        return;
+    }
+
+    // Stale or never seen: sensors only signal on change, so a steady
+    // reading ages out here and is refreshed with an explicit Get.
+    fallback(
+        input,
+        [path, handler = std::move(handler)](
+            std::optional<double> value,
+            std::chrono::steady_clock::time_point completed) {
+            if (value)
+                store(path, *value, completed);
+            handler(value, completed);
+        },
+        timeout);
+}
+
+void subscribeSensors(sdbusplus::bus_t& bus,
+                      const std::vector<std::string>& tempInputs,
+                      const std::vector<std::string>& fanInputs)
+{
+    for (const auto& in : tempInputs)
+        subscribe(bus, autotune::dbusconst::kTempSensorRoot + in);
+    for (const auto& in : fanInputs)
+        subscribe(bus, autotune::dbusconst::kFanPwmSensorRoot + in);
+}
+
+std::optional<CachedValue> cachedTempC(const std::string& input)
+{
+    return lookup(autotune::dbusconst::kTempSensorRoot + input);
+}
+
+std::optional<CachedValue> cachedFanPct(const std::string& input)
+{
+    return lookup(autotune::dbusconst::kFanPwmSensorRoot + input);
+}
+
+void readTempCCached(const std::string& input,
+                     std::chrono::steady_clock::duration maxAge,
+                     ReadHandler handler, std::chrono::microseconds timeout)
+{
+    readCached(autotune::dbusconst::kTempSensorRoot + input, input, maxAge,
+               std::move(handler), timeout, &asyncReadTempCByInput);
+}
+
+void readFanPctCached(const std::string& input,
+                      std::chrono::steady_clock::duration maxAge,
+                      ReadHandler handler, std::chrono::microseconds timeout)
+{
+    readCached(autotune::dbusconst::kFanPwmSensorRoot + input, input, maxAge,
+               std::move(handler), timeout, &asyncReadFanPctByInput);
+}
+
+} // namespace autotune::dbusio
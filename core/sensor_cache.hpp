@@ -0,0 +1,54 @@
+#pragma once
+
+#include "dbus_io.hpp"
+
+#include <sdbusplus/bus.hpp>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::dbusio
+{
+
+struct CachedValue
+{
+    double value = 0.0;
+    std::chrono::steady_clock::time_point updated;
+};
+
+/**
+ * @brief Subscribe to PropertiesChanged on xyz.openbmc_project.Sensor.Value
+ *        for the given sensors. Each sensor gets a single match no matter
+ *        how many experiments read it.
+ * @param tempInputs Temperature sensor names (e.g. CPU0_TEMP)
+ * @param fanInputs Fan PWM sensor names (e.g. PWM_DUTY0)
+ */
+void subscribeSensors(sdbusplus::bus_t& bus,
+                      const std::vector<std::string>& tempInputs,
+                      const std::vector<std::string>& fanInputs);
+
+/** Last value seen for a temperature sensor, without bus traffic. */
+std::optional<CachedValue> cachedTempC(const std::string& input);
+
+/** Last value seen for a fan PWM sensor, without bus traffic. */
+std::optional<CachedValue> cachedFanPct(const std::string& input);
+
+/**
+ * @brief Read a temperature from the cache, falling back to an explicit
+ *        Properties.Get (which refreshes the cache) when the cached value
+ *        is older than @p maxAge or missing.
+ */
+void readTempCCached(const std::string& input,
+                     std::chrono::steady_clock::duration maxAge,
+                     ReadHandler handler,
+                     std::chrono::microseconds timeout = kDefaultTimeout);
+
+/** Fan PWM counterpart of readTempCCached(). */
+void readFanPctCached(const std::string& input,
+                      std::chrono::steady_clock::duration maxAge,
+                      ReadHandler handler,
+                      std::chrono::microseconds timeout = kDefaultTimeout);
+
+} // namespace autotune::dbusio
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace autotune::core
+{
+
+/**
+ * @brief Bounded single-producer/single-consumer queue.
+ *
+ * Lock-free: the producer only writes `tail`, the consumer only writes
+ * `head`. Capacity is rounded up to a power of two and allocated once.
+ */
+template <typename T>
+class SpscQueue
+{
+  public:
+    explicit SpscQueue(size_t capacity) :
+        slots(std::bit_ceil(std::max<size_t>(capacity, 2))),
+        mask(slots.size() - 1)
+    {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /** Producer side. @return false if the queue is full. */
+    bool tryPush(T value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= slots.size())
+            return false;
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side. */
+    std::optional<T> tryPop()
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return std::nullopt;
+        T value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return value;
+    }
+
+    /** Approximate number of queued items; safe from either side. */
+    size_t size() const
+    {
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t h = head.load(std::memory_order_acquire);
+        return t - h;
+    }
+
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+  private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+} // namespace autotune::core
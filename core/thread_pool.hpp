@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace autotune::core
+{
+
+/**
+ * @brief Fixed-size pool of worker threads running submitted jobs in FIFO
+ *        order. The destructor finishes every queued job before joining.
+ */
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(size_t threads)
+    {
+        threads = std::max<size_t>(threads, 1);
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this] { run(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Queue @p f; the returned future carries its result or exception. */
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        std::packaged_task<R()> task(std::forward<F>(f));
+        auto result = task.get_future();
+        {
+            std::lock_guard lock(mutex);
+            jobs.emplace_back(std::move(task));
+        }
+        cv.notify_one();
+        return result;
+    }
+
+    /**
+     * @brief Run fn(i) for every i in [0, n) on the pool and the calling
+     *        thread; returns once all have finished.
+     *
+     * The caller claims indices like any worker and afterwards only waits
+     * for ones already running, so this is safe inside a pool job even
+     * when every worker is busy. Helpers that start after the work is
+     * gone return at once.
+     */
+    template <typename F>
+    void parallelFor(size_t n, F&& fn)
+    {
+        struct State
+        {
+            std::atomic<size_t> next{0};
+            size_t n = 0;
+            size_t done = 0;
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::function<void(size_t)> fn;
+        };
+
+        auto state = std::make_shared<State>();
+        state->n = n;
+        // Only called for claimed indices, which all finish before this
+        // function returns, so a reference to the caller's fn is enough.
+        state->fn = [&fn](size_t i) { fn(i); };
+
+        auto drain = [](State& st) {
+            for (size_t i; (i = st.next.fetch_add(1)) < st.n;)
+            {
+                st.fn(i);
+                std::lock_guard lock(st.mutex);
+                if (++st.done == st.n)
+                    st.cv.notify_all();
+            }
+        };
+
+        size_t helpers = std::min(workers.size(), n > 0 ? n - 1 : 0);
+        for (size_t h = 0; h < helpers; ++h)
+            submit([state, drain] { drain(*state); });
+
+        drain(*state);
+        std::unique_lock lock(state->mutex);
+        state->cv.wait(lock, [&] { return state->done == state->n; });
+    }
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+
+  private:
+    void run()
+    {
+        for (;;)
+        {
+            std::move_only_function<void()> job;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::move_only_function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+} // namespace autotune::core
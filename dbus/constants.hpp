@@ -9,4 +9,15 @@ constexpr const char* kMapperIface = "xyz.openbmc_project.ObjectMapper";
 
 constexpr const char* kPropertiesIface = "org.freedesktop.DBus.Properties";
 
+constexpr const char* kSensorValueIface = "xyz.openbmc_project.Sensor.Value";
+constexpr const char* kFanPwmIface = "xyz.openbmc_project.Control.FanPwm";
+
+constexpr const char* kObjectRoot = "/xyz/openbmc_project";
+constexpr const char* kTempSensorRoot =
+    "/xyz/openbmc_project/sensors/temperature/";
+constexpr const char* kFanPwmSensorRoot =
+    "/xyz/openbmc_project/sensors/fan_pwm/";
+constexpr const char* kFanPwmControlRoot =
+    "/xyz/openbmc_project/control/fanpwm/";
+
 } // namespace autotune::dbusconst
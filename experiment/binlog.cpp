@@ -0,0 +1,326 @@
+#include "binlog.hpp"
+
+#include <zlib.h>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string_view>
+
+namespace autotune::experiment::binlog
+{
+
+static void putVarint(std::string& out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static void putSigned(std::string& out, int64_t v)
+{
+    // zigzag: small magnitudes of either sign stay short
+    putVarint(out, (static_cast<uint64_t>(v) << 1) ^
+                       static_cast<uint64_t>(v >> 63));
+}
+
+static bool getVarint(const std::string& buf, size_t& pos, uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < buf.size(); shift += 7)
+    {
+        auto byte = static_cast<uint8_t>(buf[pos++]);
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static bool getSigned(const std::string& buf, size_t& pos, int64_t& v)
+{
+    uint64_t u;
+    if (!getVarint(buf, pos, u))
+        return false;
+    v = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+    return true;
+}
+
+static bool readVarint(std::istream& in, uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int c = in.get();
+        if (c == EOF)
+            return false;
+        v |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static int64_t quantize(double v, double scale)
+{
+    return std::isfinite(v) ? std::llround(v * scale) : 0;
+}
+
+BinLogSink::BinLogSink(std::string metaJson, bool deflate) : deflate(deflate)
+{
+    auto j = nlohmann::json::parse(metaJson, nullptr, false);
+    if (j.is_discarded() || !j.is_object())
+        j = nlohmann::json::object();
+    j["scales"] = {{"time", scales.time},   {"temp", scales.temp},
+                   {"pwm", scales.pwm},     {"slope", scales.slope},
+                   {"rmse", scales.rmse},   {"mean", scales.mean}};
+    meta = j.dump();
+}
+
+void BinLogSink::header(std::string& out)
+{
+    out.append(kMagic, sizeof(kMagic));
+    out.push_back(static_cast<char>(kVersion));
+    out.push_back(static_cast<char>(deflate ? kFlagDeflate : 0));
+    putVarint(out, meta.size());
+    out += meta;
+}
+
+void BinLogSink::sample(const DataPoint& dp, std::string& out)
+{
+    const int64_t q[7] = {dp.n,
+                          quantize(dp.time, scales.time),
+                          quantize(dp.temp, scales.temp),
+                          quantize(dp.pwm, scales.pwm),
+                          quantize(dp.slope, scales.slope),
+                          quantize(dp.rmse, scales.rmse),
+                          quantize(dp.mean, scales.mean)};
+
+    for (size_t i = 0; i < 7; ++i)
+    {
+        putSigned(block, blockCount == 0 ? q[i] : q[i] - prev[i]);
+        prev[i] = q[i];
+    }
+    blockCount++;
+
+    // A writer that falls behind must not build a block no reader takes.
+    if (block.size() + kMaxSampleBytes > kMaxBlockBytes)
+        flush(out);
+}
+
+void BinLogSink::note(const std::string& text, std::string& out)
+{
+    // Keep notes in order relative to the samples around them.
+    flush(out);
+    std::string_view kept(text.data(), std::min(text.size(), kMaxBlockBytes));
+    out.push_back('N');
+    putVarint(out, kept.size());
+    out += kept;
+}
+
+size_t BinLogSink::pending() const
+{
+    return block.size();
+}
+
+void BinLogSink::flush(std::string& out)
+{
+    if (blockCount == 0)
+        return;
+
+    std::string stored;
+    if (deflate)
+    {
+        uLongf len = compressBound(block.size());
+        stored.resize(len);
+        if (compress2(reinterpret_cast<Bytef*>(stored.data()), &len,
+                      reinterpret_cast<const Bytef*>(block.data()),
+                      block.size(), Z_BEST_SPEED) == Z_OK)
+        {
+            stored.resize(len);
+        }
+        else
+        {
+            // Cannot happen with a compressBound() buffer; keep the data.
+            std::cerr << "[BinLog] compress failed\n";
+            stored.clear();
+        }
+    }
+
+    out.push_back('B');
+    putVarint(out, blockCount);
+    putVarint(out, block.size());
+    if (deflate && !stored.empty())
+    {
+        putVarint(out, stored.size());
+        out += stored;
+    }
+    else
+    {
+        putVarint(out, 0); // storedLen 0: payload is raw
+        out += block;
+    }
+
+    block.clear();
+    blockCount = 0;
+}
+
+bool Reader::open(const std::string& path)
+{
+    in.open(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+
+    char magic[sizeof(kMagic)];
+    in.read(magic, sizeof(magic));
+    int version = in.get();
+    int f = in.get();
+    if (!in || std::string(magic, sizeof(magic)) !=
+                   std::string(kMagic, sizeof(kMagic)))
+        return false;
+    if (version != kVersion)
+    {
+        std::cerr << "[BinLog] Unsupported version " << version << "\n";
+        return false;
+    }
+    flags = static_cast<uint8_t>(f);
+
+    uint64_t len;
+    if (!readVarint(in, len) || len > kMaxBlockBytes)
+    {
+        std::cerr << "[BinLog] Bad metadata length\n";
+        return false;
+    }
+    meta.resize(len);
+    in.read(meta.data(), static_cast<std::streamsize>(len));
+    if (!in)
+        return false;
+
+    auto j = nlohmann::json::parse(meta, nullptr, false);
+    if (!j.is_discarded() && j.contains("scales"))
+    {
+        const auto& s = j["scales"];
+        scales.time = s.value("time", scales.time);
+        scales.temp = s.value("temp", scales.temp);
+        scales.pwm = s.value("pwm", scales.pwm);
+        scales.slope = s.value("slope", scales.slope);
+        scales.rmse = s.value("rmse", scales.rmse);
+        scales.mean = s.value("mean", scales.mean);
+    }
+    return true;
+}
+
+bool Reader::fail()
+{
+    bad = true;
+    return false;
+}
+
+bool Reader::loadChunk()
+{
+    int tag = in.get();
+    if (tag == EOF)
+        return false;
+
+    if (tag == 'N')
+    {
+        uint64_t len;
+        if (!readVarint(in, len) || len > kMaxBlockBytes)
+            return fail();
+        pendingNote.resize(len);
+        in.read(pendingNote.data(), static_cast<std::streamsize>(len));
+        if (!in)
+            return fail();
+        havePendingNote = true;
+        return true;
+    }
+
+    if (tag != 'B')
+        return fail();
+
+    uint64_t count, rawLen, storedLen;
+    if (!readVarint(in, count) || !readVarint(in, rawLen) ||
+        !readVarint(in, storedLen))
+        return fail();
+    // The lengths come from the file: check them before allocating. A
+    // sample takes 7 to kMaxSampleBytes bytes.
+    if (count == 0 || rawLen > kMaxBlockBytes || count > rawLen / 7 ||
+        rawLen > count * kMaxSampleBytes ||
+        storedLen > compressBound(static_cast<uLong>(rawLen)))
+        return fail();
+
+    if (storedLen == 0)
+    {
+        payload.resize(rawLen);
+        in.read(payload.data(), static_cast<std::streamsize>(rawLen));
+        if (!in)
+            return fail();
+    }
+    else
+    {
+        std::string stored(storedLen, '\0');
+        in.read(stored.data(), static_cast<std::streamsize>(storedLen));
+        if (!in)
+            return fail();
+        payload.resize(rawLen);
+        uLongf outLen = rawLen;
+        if (uncompress(reinterpret_cast<Bytef*>(payload.data()), &outLen,
+                       reinterpret_cast<const Bytef*>(stored.data()),
+                       stored.size()) != Z_OK ||
+            outLen != rawLen)
+            return fail();
+    }
+
+    pos = 0;
+    remaining = count;
+    return true;
+}
+
+bool Reader::next(Entry& e)
+{
+    for (;;)
+    {
+        if (havePendingNote)
+        {
+            havePendingNote = false;
+            e.kind = Entry::Kind::Note;
+            e.note = std::move(pendingNote);
+            return true;
+        }
+
+        if (remaining > 0)
+        {
+            bool first = (pos == 0);
+            int64_t q[7];
+            for (size_t i = 0; i < 7; ++i)
+            {
+                int64_t v;
+                if (!getSigned(payload, pos, v))
+                    return fail();
+                q[i] = first ? v : prev[i] + v;
+                prev[i] = q[i];
+            }
+            remaining--;
+
+            e.kind = Entry::Kind::Sample;
+            e.dp = DataPoint{q[0],
+                             static_cast<double>(q[1]) / scales.time,
+                             static_cast<double>(q[2]) / scales.temp,
+                             static_cast<double>(q[3]) / scales.pwm,
+                             static_cast<double>(q[4]) / scales.slope,
+                             static_cast<double>(q[5]) / scales.rmse,
+                             static_cast<double>(q[6]) / scales.mean};
+            return true;
+        }
+
+        if (!loadChunk())
+            return false;
+    }
+}
+
+} // namespace autotune::experiment::binlog
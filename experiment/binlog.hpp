@@ -0,0 +1,136 @@
+#pragma once
+
+#include "log_writer.hpp"
+#include "sample_store.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment::binlog
+{
+
+/*
+ * Binary experiment log, version 1.
+ *
+ *   "PATLOG" u8 version u8 flags
+ *   varint metaLen, metaLen bytes of JSON (experiment config, scales)
+ *   chunks until EOF:
+ *     'B' varint count, varint rawLen, varint storedLen, storedLen bytes
+ *         -- a block of `count` samples; the payload is deflated when
+ *            kFlagDeflate is set, rawLen is its inflated size
+ *     'N' varint len, len bytes -- a free-form note (e.g. step window)
+ *
+ * Each sample is seven zigzag varints (n, time, temp, pwm, slope, rmse,
+ * mean), quantized by the scales in the metadata. The first sample of a
+ * block is absolute and the rest are deltas from their predecessor, so
+ * blocks decode independently.
+ */
+
+constexpr char kMagic[6] = {'P', 'A', 'T', 'L', 'O', 'G'};
+constexpr uint8_t kVersion = 1;
+constexpr uint8_t kFlagDeflate = 0x01;
+
+/** Seven varints of at most ten bytes each. */
+constexpr size_t kMaxSampleBytes = 70;
+/** Largest inflated block, note or metadata a reader accepts. */
+constexpr size_t kMaxBlockBytes = size_t{4} << 20;
+
+/** Quantization: stored integer = llround(value * scale). */
+struct Scales
+{
+    double time = 1e6;  // microseconds
+    double temp = 1e4;  // 0.1 m°C
+    double pwm = 1e3;
+    double slope = 1e7;
+    double rmse = 1e6;
+    double mean = 1e6;
+};
+
+/**
+ * @brief LogSink producing the binary format. Samples are buffered into a
+ *        block that is emitted on every writer flush.
+ */
+class BinLogSink : public LogSink
+{
+  public:
+    /**
+     * @param metaJson Experiment description stored in the header; the
+     *        quantization scales are added to it.
+     * @param deflate Compress sample blocks with zlib.
+     */
+    BinLogSink(std::string metaJson, bool deflate);
+
+    void header(std::string& out) override;
+    void sample(const DataPoint& dp, std::string& out) override;
+    void note(const std::string& text, std::string& out) override;
+    void flush(std::string& out) override;
+    size_t pending() const override;
+
+  private:
+    std::string meta;
+    bool deflate;
+    Scales scales;
+
+    std::string block;
+    size_t blockCount = 0;
+    int64_t prev[7] = {};
+};
+
+/**
+ * @brief Streaming reader: holds one chunk in memory at a time.
+ */
+class Reader
+{
+  public:
+    struct Entry
+    {
+        enum class Kind
+        {
+            Sample,
+            Note
+        };
+
+        Kind kind = Kind::Sample;
+        DataPoint dp{};
+        std::string note;
+    };
+
+    /** @return false if the file is missing or not a supported log. */
+    bool open(const std::string& path);
+
+    /** JSON metadata from the header. */
+    const std::string& metadata() const
+    {
+        return meta;
+    }
+
+    /** Next sample or note. @return false at end of file or on error. */
+    bool next(Entry& e);
+
+    /** True if next() stopped because of a truncated or corrupt chunk. */
+    bool corrupt() const
+    {
+        return bad;
+    }
+
+  private:
+    bool loadChunk();
+    bool fail();
+
+    std::ifstream in;
+    std::string meta;
+    uint8_t flags = 0;
+    Scales scales;
+    bool bad = false;
+
+    std::string payload;
+    size_t pos = 0;
+    size_t remaining = 0;
+    int64_t prev[7] = {};
+    std::string pendingNote;
+    bool havePendingNote = false;
+};
+
+} // namespace autotune::experiment::binlog
@@ -0,0 +1,410 @@
+#include "excitation_experiment.hpp"
+
+#include "../core/utils.hpp"
+#include "../process_models/gain_schedule.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace autotune::experiment
+{
+
+// Feedback taps of maximum-length Fibonacci LFSRs, as a mask over the
+// register shifted right by one each bit; index is the order.
+static constexpr unsigned prbsTaps[] = {
+    0,
+    0,
+    0x003, // x^2 + x + 1
+    0x003, // x^3 + x^2 + 1
+    0x003, // x^4 + x^3 + 1
+    0x005, // x^5 + x^3 + 1
+    0x003, // x^6 + x^5 + 1
+    0x003, // x^7 + x^6 + 1
+    0x01d, // x^8 + x^6 + x^5 + x^4 + 1
+    0x011, // x^9 + x^5 + 1
+    0x009, // x^10 + x^7 + 1
+};
+
+std::vector<double> excitationLevels(const config::ExcitationConfig& cfg)
+{
+    std::vector<double> out;
+    if (cfg.signal == "multistep")
+    {
+        out = cfg.levels;
+    }
+    else if (cfg.signal == "staircase")
+    {
+        int n = std::max(cfg.stairSteps, 1);
+        double span = cfg.highPwmDuty - cfg.lowPwmDuty;
+        for (int i = 0; i <= n; ++i)
+            out.push_back(cfg.lowPwmDuty + span * i / n);
+        // Walking back down shows hysteresis and gain changes.
+        for (int i = n - 1; i >= 0; --i)
+            out.push_back(cfg.lowPwmDuty + span * i / n);
+    }
+    else if (cfg.signal == "prbs")
+    {
+        int order = std::clamp(cfg.prbsOrder, 2, 10);
+        unsigned mask = prbsTaps[order];
+        unsigned state = (1u << order) - 1;
+        size_t bits = (size_t{1} << order) - 1;
+        for (size_t b = 0; b < bits; ++b)
+        {
+            out.push_back((state & 1u) ? cfg.highPwmDuty : cfg.lowPwmDuty);
+            unsigned feedback = std::popcount(state & mask) & 1u;
+            state = (state >> 1) | (feedback << (order - 1));
+        }
+    }
+    else
+    {
+        std::cerr << "[Excitation] Unknown signal '" << cfg.signal
+                  << "' for " << cfg.name << "\n";
+    }
+    return out;
+}
+
+ExcitationExperiment::ExcitationExperiment(
+    boost::asio::io_context& io, core::ThreadPool& analysisPool,
+    const config::BasicSetting& basic, const config::ExcitationConfig& cfg) :
+    PollingExperiment(io, analysisPool, basic, "Excitation", "excitation",
+                      1),
+    cfg(cfg), sensorList{cfg.tempSensor}, levels(excitationLevels(cfg)),
+    stats(static_cast<size_t>(std::max(basic.windowSize, 1)))
+{}
+
+int64_t ExcitationExperiment::totalIterations() const
+{
+    return std::max<int64_t>(cfg.settleIterations, 0) +
+           static_cast<int64_t>(levels.size()) *
+               std::max<int64_t>(cfg.holdIterations, 1) +
+           std::max<int64_t>(cfg.tailIterations, 0);
+}
+
+double ExcitationExperiment::progress() const
+{
+    int64_t total = totalIterations();
+    if (total <= 0)
+        return 0.0;
+    return std::min(1.0, static_cast<double>(currentIteration) / total);
+}
+
+bool ExcitationExperiment::beginRun()
+{
+    if (levels.empty())
+    {
+        std::cerr << "[Excitation] " << cfg.name << " has no levels\n";
+        return false;
+    }
+
+    std::cerr << "[Excitation] " << cfg.name << ": " << cfg.signal << ", "
+              << levels.size() << " levels\n";
+    nextLevel = 0;
+    baseline = 0.0;
+    inputs.clear();
+    stats.reset();
+    samples.reset(static_cast<size_t>(totalIterations()), 1,
+                  basicCfg.compactStorage);
+
+    currentDuty = cfg.basePwmDuty;
+    writePwm(cfg.fans, cfg.basePwmDuty);
+    return true;
+}
+
+std::string ExcitationExperiment::logMetadata(const std::string&) const
+{
+    nlohmann::json j;
+    j["tempsensor"] = cfg.tempSensor;
+    j["excitation"] = cfg.name;
+    j["signal"] = cfg.signal;
+    j["pollinterval"] = basicCfg.pollInterval;
+    j["windowsize"] = basicCfg.windowSize;
+    j["fans"] = cfg.fans;
+    j["basepwmduty"] = cfg.basePwmDuty;
+    j["levels"] = levels;
+    j["settleiterations"] = cfg.settleIterations;
+    j["holditerations"] = cfg.holdIterations;
+    j["tailiterations"] = cfg.tailIterations;
+    return j.dump();
+}
+
+void ExcitationExperiment::recordSample(
+    const std::vector<std::optional<double>>& temps, double timestamp)
+{
+    if (!temps.front())
+    {
+        // A made-up reading would enter the fit as a real sample.
+        std::cerr << "[Excitation] " << cfg.name
+                  << " read failed, sample skipped\n";
+        return;
+    }
+    double temp = *temps.front();
+    stats.push(timestamp, temp);
+    ChannelSample cv{temp, stats.slope(), stats.rmse(), stats.mean()};
+    logWriters.front()->sample(DataPoint{currentIteration, timestamp, temp,
+                                         currentDuty, cv.slope, cv.rmse,
+                                         cv.mean});
+    if (!samples.append(timestamp, currentDuty, {&cv, 1}))
+    {
+        std::cerr << "[Excitation] Sample store full for " << cfg.name
+                  << ", sample " << currentIteration << " not kept\n";
+    }
+    currentIteration++;
+
+    int64_t nextAt = std::max<int64_t>(cfg.settleIterations, 0) +
+                     static_cast<int64_t>(nextLevel) *
+                         std::max<int64_t>(cfg.holdIterations, 1);
+    if (nextLevel <= levels.size() && currentIteration >= nextAt)
+    {
+        if (nextLevel == 0)
+        {
+            // The fit starts here, at rest at the base duty.
+            baseline = stats.full() ? stats.mean() : temp;
+            inputs.push_back(
+                {timestamp, core::scaleRawToDuty(
+                                static_cast<int>(cfg.basePwmDuty))});
+            logSync();
+        }
+        double duty = nextLevel < levels.size() ? levels[nextLevel]
+                                                : cfg.basePwmDuty;
+        nextLevel++;
+        applyLevel(duty, timestamp);
+    }
+
+    if (currentIteration >= totalIterations())
+    {
+        std::cout << "[Excitation] Finished " << cfg.name << "\n";
+        submitAnalysis();
+    }
+}
+
+void ExcitationExperiment::applyLevel(double duty, double time)
+{
+    currentDuty = duty;
+    // Refined to the write's issue time once it completes.
+    size_t index = inputs.size();
+    inputs.push_back({time, core::scaleRawToDuty(static_cast<int>(duty))});
+
+    auto weak = weakSelf(this);
+    uint64_t id = runId;
+    writePwm(cfg.fans, duty,
+             [weak, id, index, duty](const io::WriteResult& result) {
+                 auto self = weak.lock();
+                 if (!self || self->runId != id)
+                     return;
+                 std::chrono::duration<double> issued =
+                     result.issued - self->startTime;
+                 std::chrono::duration<double> acked =
+                     result.acked - self->startTime;
+                 if (index < self->inputs.size())
+                     self->inputs[index].time = issued.count();
+
+                 std::ostringstream line;
+                 line << "#level=" << index << ",duty=" << duty
+                      << ",step_issued=" << issued.count()
+                      << ",step_acked=" << acked.count();
+                 self->logNote(line.str());
+             });
+}
+
+// Each stair is held until it settles, so every level change is fitted
+// on its own segment from the temperature it started at.
+static std::vector<process_models::StepFit> fitEachStep(
+    std::span<const double> time, std::span<const double> temp,
+    std::span<const process_models::InputLevel> inputs)
+{
+    std::vector<process_models::StepFit> fits;
+    size_t lo = 0;
+    for (size_t i = 1; i < inputs.size(); ++i)
+    {
+        double from = inputs[i - 1].duty;
+        double to = inputs[i].duty;
+        double end = i + 1 < inputs.size()
+                         ? inputs[i + 1].time
+                         : std::numeric_limits<double>::infinity();
+        while (lo < time.size() && time[lo] < inputs[i].time)
+            ++lo;
+        size_t hi = lo;
+        while (hi < time.size() && time[hi] < end)
+            ++hi;
+        if (std::abs(to - from) < 1e-6 || lo == 0 || hi - lo < 3)
+            continue;
+
+        // Start from the last few samples of the previous stair.
+        size_t n = std::min<size_t>(lo, 10);
+        double start = 0.0;
+        for (size_t j = lo - n; j < lo; ++j)
+            start += temp[j];
+        start /= static_cast<double>(n);
+
+        process_models::StepInput step{inputs[i].time, to - from};
+        auto p = process_models::identifyStepSequence(
+            time.subspan(lo, hi - lo), temp.subspan(lo, hi - lo), {&step, 1},
+            start);
+        if (p.front().valid)
+            fits.push_back({from, to, p.front().params});
+    }
+    return fits;
+}
+
+// Steps that may not settle are fitted together as a superposition. The
+// joint refinement grows with the step count, so long sequences are left
+// to the whole-record fit, and steps the record cannot resolve are left
+// out.
+static std::vector<process_models::StepFit> fitStepsJointly(
+    std::span<const double> time, std::span<const double> temp,
+    std::span<const process_models::InputLevel> inputs, double baseline)
+{
+    constexpr size_t maxSteps = 16;
+    std::vector<process_models::StepFit> fits;
+    if (inputs.size() < 2 || inputs.size() - 1 > maxSteps)
+        return fits;
+
+    std::vector<process_models::StepInput> steps;
+    for (size_t i = 1; i < inputs.size(); ++i)
+        steps.push_back({inputs[i].time, inputs[i].duty - inputs[i - 1].duty});
+    auto seq =
+        process_models::identifyStepSequence(time, temp, steps, baseline);
+
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        if (!seq[i].valid)
+            continue;
+        fits.push_back({inputs[i].duty, inputs[i + 1].duty, seq[i].params});
+    }
+    return fits;
+}
+
+static void writeSchedule(const std::string& path, const std::string& name,
+                          const std::string& sensor, double ratio,
+                          std::span<const process_models::ScheduleEntry> table)
+{
+    nlohmann::json j;
+    j["name"] = name;
+    j["tempsensor"] = sensor;
+    j["imcratio"] = ratio;
+    j["entries"] = nlohmann::json::array();
+    for (const auto& e : table)
+    {
+        j["entries"].push_back({{"duty", e.duty},
+                                {"k", e.model.k},
+                                {"tau", e.model.tau},
+                                {"theta", e.model.theta},
+                                {"pid",
+                                 {{"kp", e.pid.kp},
+                                  {"ki", e.pid.ki},
+                                  {"kd", e.pid.kd}}},
+                                {"pi", {{"kp", e.pi.kp}, {"ki", e.pi.ki}}}});
+    }
+    std::ofstream out(path);
+    out << j.dump(4) << "\n";
+}
+
+void ExcitationExperiment::submitAnalysis()
+{
+    struct Job
+    {
+        std::string path;
+        std::string schedulePath;
+        std::string name;
+        std::string sensor;
+        std::string signal;
+        double imcRatio;
+        std::shared_ptr<const SampleStore> samples;
+        std::vector<process_models::InputLevel> inputs;
+        double baseline;
+    };
+
+    auto job = std::make_shared<Job>();
+    job->path = logDir + "/excitation_" + cfg.name + ".txt";
+    job->schedulePath = logDir + "/gainschedule_" + cfg.name + ".json";
+    job->name = cfg.name;
+    job->sensor = cfg.tempSensor;
+    job->signal = cfg.signal;
+    job->imcRatio = cfg.imcRatio;
+    job->samples = std::make_shared<const SampleStore>(std::move(samples));
+    job->inputs = std::move(inputs);
+    job->baseline = baseline;
+
+    endRun([job] {
+        std::ofstream out(job->path);
+        out << "Name:" << job->name << "\n";
+        out << "Signal=" << job->signal << "\n";
+        if (job->inputs.size() < 2)
+        {
+            out << "Levels=0\n";
+            return;
+        }
+
+        // Fit from the end of the settle phase on.
+        auto allTimes = job->samples->times();
+        auto allTemps = job->samples->temps();
+        size_t first = static_cast<size_t>(
+            std::lower_bound(allTimes.begin(), allTimes.end(),
+                             job->inputs.front().time) -
+            allTimes.begin());
+        auto time = allTimes.subspan(first);
+        auto temp = allTemps.subspan(first);
+
+        out << "Levels=" << job->inputs.size() - 1 << "\n";
+        out << "Samples=" << time.size() << "\n\n";
+
+        auto fit = process_models::identifyRecord(time, temp, job->inputs,
+                                                  job->baseline);
+        out << "------Whole-record FOPDT--------\n";
+        if (fit.valid)
+        {
+            out << "k=" << fit.params.k << "\n";
+            out << "tau=" << fit.params.tau << "\n";
+            out << "theta=" << fit.params.theta << "\n";
+            out << "Baseline=" << fit.baseline << "\n";
+            out << "RMSE=" << fit.rmse << "\n\n";
+        }
+        else
+        {
+            out << "Fit failed\n\n";
+        }
+
+        std::vector<process_models::StepFit> local;
+        if (job->signal == "staircase")
+            local = fitEachStep(time, temp, job->inputs);
+        else if (job->signal == "multistep")
+            local = fitStepsJointly(time, temp, job->inputs, job->baseline);
+        if (local.empty())
+            return;
+
+        out << "------Local Steps--------\n";
+        double kMin = 0.0;
+        double kMax = 0.0;
+        for (size_t i = 0; i < local.size(); ++i)
+        {
+            const auto& s = local[i];
+            out << "Step" << i << ": " << s.fromDuty << "->" << s.toDuty
+                << " k=" << s.params.k << " tau=" << s.params.tau
+                << " theta=" << s.params.theta << "\n";
+            kMin = i ? std::min(kMin, s.params.k) : s.params.k;
+            kMax = i ? std::max(kMax, s.params.k) : s.params.k;
+        }
+        // Relative spread of the local gains around the whole-record gain;
+        // a linear plant keeps this small.
+        if (fit.valid && std::abs(fit.params.k) > 1e-9)
+            out << "GainSpread=" << (kMax - kMin) / std::abs(fit.params.k)
+                << "\n";
+
+        if (job->signal == "staircase")
+        {
+            auto table = process_models::buildSchedule(local, job->imcRatio);
+            writeSchedule(job->schedulePath, job->name, job->sensor,
+                          job->imcRatio, table);
+            out << "Schedule=" << job->schedulePath << "\n";
+        }
+    });
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "../core/rolling_stats.hpp"
+#include "../core/thread_pool.hpp"
+#include "../process_models/fopdt.hpp"
+#include "polling_experiment.hpp"
+#include "sample_store.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Duty levels of an excitation sequence, one per holdIterations
+ *        slot: the configured multi-step levels, a staircase from low to
+ *        high and back, or one period of a maximum-length PRBS.
+ */
+std::vector<double> excitationLevels(const config::ExcitationConfig& cfg);
+
+/**
+ * @brief PRBS / multi-step / staircase identification experiment.
+ *
+ * Holds the fans at the base duty for settleIterations, plays the
+ * excitation sequence, then returns to the base duty for tailIterations.
+ * One FOPDT model is fitted to the whole record by simulating it against
+ * the duty trace that was actually written. For multi-step and staircase
+ * signals every level change is also fitted on its own, so the spread of
+ * the local gains shows how linear the plant is over the range.
+ */
+class ExcitationExperiment : public PollingExperiment
+{
+  public:
+    ExcitationExperiment(boost::asio::io_context& io,
+                         core::ThreadPool& analysisPool,
+                         const config::BasicSetting& basic,
+                         const config::ExcitationConfig& cfg);
+
+    const std::string& name() const override
+    {
+        return cfg.name;
+    }
+
+    double progress() const override;
+
+    std::vector<std::string> fans() const override
+    {
+        return cfg.fans;
+    }
+
+    const std::vector<std::string>& sensors() const override
+    {
+        return sensorList;
+    }
+
+    const std::vector<std::string>& coupledSensors() const override
+    {
+        return cfg.coupledSensors;
+    }
+
+    int priority() const override
+    {
+        return cfg.priority;
+    }
+
+  private:
+    bool beginRun() override;
+    void recordSample(const std::vector<std::optional<double>>& temps,
+                      double timestamp) override;
+    std::string logMetadata(const std::string& sensor) const override;
+    void applyLevel(double duty, double time);
+    int64_t totalIterations() const;
+    void submitAnalysis();
+
+    config::ExcitationConfig cfg;
+    std::vector<std::string> sensorList;
+    std::vector<double> levels;
+
+    size_t nextLevel = 0;
+    double currentDuty = 0.0;
+    double baseline = 0.0;
+    // Duty (percent) written at each change, relative to startTime.
+    std::vector<process_models::InputLevel> inputs;
+
+    core::RollingStats stats;
+    SampleStore samples;
+};
+
+} // namespace autotune::experiment
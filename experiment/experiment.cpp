@@ -0,0 +1,73 @@
+#include "experiment.hpp"
+
+#include "binlog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace autotune::experiment
+{
+
+std::string toString(AnalysisStatus status)
+{
+    switch (status)
+    {
+        case AnalysisStatus::Idle:
+            return "Idle";
+        case AnalysisStatus::Pending:
+            return "Pending";
+        case AnalysisStatus::Running:
+            return "Running";
+        case AnalysisStatus::Done:
+            return "Done";
+    }
+    return "Unknown";
+}
+
+uint64_t Experiment::beginAnalysis()
+{
+    uint64_t id = ++analysisId;
+    setAnalysisStatus(id, AnalysisStatus::Pending);
+    return id;
+}
+
+void Experiment::setAnalysisStatus(uint64_t id, AnalysisStatus status)
+{
+    if (id != analysisId || status == analysisStatus)
+        return;
+    analysisStatus = status;
+    std::cerr << "[Experiment] Analysis " << toString(status) << " for "
+              << name() << "\n";
+    if (analysisStatusChanged)
+        analysisStatusChanged();
+}
+
+std::unique_ptr<LogWriter>
+    Experiment::makeLogWriter(const config::BasicSetting& basic)
+{
+    return std::make_unique<LogWriter>(LogPolicy{
+        static_cast<size_t>(std::max(basic.logFlushBytes, 0)),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::duration<double>(basic.logFlushInterval)),
+        LogPolicy{}.queueCapacity});
+}
+
+void Experiment::openLog(LogWriter& writer, const std::string& base,
+                         const std::string& metaJson,
+                         const config::BasicSetting& basic, bool append)
+{
+    if (basic.logFormat == "binary")
+    {
+        writer.open(base + ".bin",
+                    std::make_unique<binlog::BinLogSink>(metaJson,
+                                                         basic.logDeflate),
+                    append);
+    }
+    else
+    {
+        writer.open(base + ".txt", std::make_unique<CsvLogSink>(), append);
+    }
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "log_writer.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+enum class AnalysisStatus
+{
+    Idle,
+    Pending,
+    Running,
+    Done
+};
+
+std::string toString(AnalysisStatus status);
+
+/**
+ * @brief Common interface of every experiment type, used by main() for the
+ *        D-Bus objects and by the Scheduler to run a batch.
+ */
+class Experiment
+{
+  public:
+    virtual ~Experiment() = default;
+
+    virtual void tick() = 0;
+    virtual void setEnabled(bool enabled) = 0;
+    virtual bool getEnabled() const = 0;
+
+    /** Object path leaf and log directory name. */
+    virtual const std::string& name() const = 0;
+
+    /** Fraction of the current run completed, 0..1. */
+    virtual double progress() const = 0;
+
+    /** Every fan the experiment drives. */
+    virtual std::vector<std::string> fans() const = 0;
+
+    /** Every temperature sensor the experiment records. */
+    virtual const std::vector<std::string>& sensors() const = 0;
+
+    /** Sensors outside sensors() that the experiment's fans disturb. */
+    virtual const std::vector<std::string>& coupledSensors() const = 0;
+
+    /** Scheduling priority; higher runs first. */
+    virtual int priority() const = 0;
+
+    virtual size_t logQueueDepth() const = 0;
+    virtual uint64_t logDropped() const = 0;
+
+    AnalysisStatus getAnalysisStatus() const
+    {
+        return analysisStatus;
+    }
+
+    /** Called on the io_context thread whenever the analysis status moves. */
+    void onAnalysisStatusChanged(std::function<void()> cb)
+    {
+        analysisStatusChanged = std::move(cb);
+    }
+
+  protected:
+    /** Start a new analysis; later updates for older ones are ignored. */
+    uint64_t beginAnalysis();
+    void setAnalysisStatus(uint64_t id, AnalysisStatus status);
+
+    /** Writer configured from the basicsetting log keys. */
+    static std::unique_ptr<LogWriter>
+        makeLogWriter(const config::BasicSetting& basic);
+
+    /** Open @p base + ".txt" or ".bin" as selected by "logformat". */
+    static void openLog(LogWriter& writer, const std::string& base,
+                        const std::string& metaJson,
+                        const config::BasicSetting& basic,
+                        bool append = false);
+
+  private:
+    AnalysisStatus analysisStatus = AnalysisStatus::Idle;
+    // Identifies the latest submitted analysis; stale updates are ignored.
+    uint64_t analysisId = 0;
+    std::function<void()> analysisStatusChanged;
+};
+
+} // namespace autotune::experiment
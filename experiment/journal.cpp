@@ -0,0 +1,254 @@
+#include "journal.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace autotune::experiment
+{
+
+namespace
+{
+
+constexpr char kMagic[7] = {'P', 'A', 'T', 'J', 'R', 'N', 'L'};
+constexpr uint8_t kVersion = 1;
+
+struct Header
+{
+    char magic[7];
+    uint8_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t capacity;
+    uint8_t pad[40];
+};
+
+static_assert(sizeof(Header) == 64);
+
+constexpr size_t kCheckOffset = offsetof(JournalRecord, check);
+constexpr size_t kPageBytes = 4096;
+
+bool headerValid(const Header& h)
+{
+    return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+           h.version == kVersion && h.recordSize == sizeof(JournalRecord);
+}
+
+// Covers everything before the checksum plus the slot, so a record copied
+// to the wrong place or left over in a zeroed slot never validates.
+uint64_t checksum(const uint8_t* bytes, size_t slot)
+{
+    uint64_t h = Journal::hash(
+        {reinterpret_cast<const char*>(bytes), kCheckOffset});
+    h ^= slot + 1;
+    h *= 0x100000001b3ULL;
+    return h;
+}
+
+size_t countValid(const uint8_t* records, size_t capacity)
+{
+    size_t n = 0;
+    for (; n < capacity; ++n)
+    {
+        const uint8_t* slot = records + n * sizeof(JournalRecord);
+        uint64_t stored;
+        std::memcpy(&stored, slot + kCheckOffset, sizeof(stored));
+        if (stored != checksum(slot, n))
+            break;
+    }
+    return n;
+}
+
+} // namespace
+
+uint64_t Journal::hash(std::string_view text)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : text)
+    {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+Journal::~Journal()
+{
+    close();
+}
+
+bool Journal::open(const std::string& path, size_t records, bool resume)
+{
+    close();
+
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (resume ? 0 : O_TRUNC);
+    fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "[Journal] open " << path
+                  << " failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    Header h{};
+    size_t existing = 0;
+    if (resume && ::pread(fd, &h, sizeof(h), 0) == sizeof(h) &&
+        headerValid(h))
+    {
+        existing = static_cast<size_t>(h.capacity);
+    }
+    else if (resume && ::ftruncate(fd, 0) != 0)
+    {
+        // Not a journal we can continue; start it over.
+        std::cerr << "[Journal] truncate " << path
+                  << " failed: " << std::strerror(errno) << "\n";
+    }
+
+    capacity = std::max(records, existing);
+    mappedBytes = sizeof(Header) + capacity * sizeof(JournalRecord);
+    // Reserve the blocks rather than leaving a sparse file: a store to a
+    // mapped hole that the file system cannot back raises SIGBUS.
+    if (int err = ::posix_fallocate(fd, 0, static_cast<off_t>(mappedBytes)))
+    {
+        std::cerr << "[Journal] reserve " << path
+                  << " failed: " << std::strerror(err) << "\n";
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    void* p = ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, 0);
+    if (p == MAP_FAILED)
+    {
+        std::cerr << "[Journal] mmap " << path
+                  << " failed: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    base = static_cast<uint8_t*>(p);
+
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.recordSize = sizeof(JournalRecord);
+    h.capacity = capacity;
+    std::memcpy(base, &h, sizeof(h));
+
+    used = existing ? countValid(base + sizeof(Header), capacity) : 0;
+    // Whatever follows the valid prefix (a torn record and anything after
+    // it) must not become valid again once appends reach it. Zeroing it
+    // also takes the first write fault of every free page here rather
+    // than on the sample path.
+    std::memset(base + sizeof(Header) + used * sizeof(JournalRecord), 0,
+                (capacity - used) * sizeof(JournalRecord));
+    syncRange(0, mappedBytes);
+    synced = sizeof(Header) + used * sizeof(JournalRecord);
+    return true;
+}
+
+void Journal::close()
+{
+    if (base)
+    {
+        ::munmap(base, mappedBytes);
+        base = nullptr;
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+    mappedBytes = 0;
+    capacity = 0;
+    used = 0;
+    synced = 0;
+}
+
+bool Journal::append(JournalRecord r)
+{
+    if (!base || used >= capacity)
+        return false;
+
+    uint8_t* slot = base + sizeof(Header) + used * sizeof(JournalRecord);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&r);
+    uint64_t check = checksum(bytes, used);
+
+    // Body first, checksum last: a crash in between leaves an invalid
+    // slot that ends the journal.
+    std::memcpy(slot, bytes, kCheckOffset);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(slot + kCheckOffset, &check, sizeof(check));
+    used++;
+    return true;
+}
+
+void Journal::sync()
+{
+    if (!base)
+        return;
+    // Restart at the page of the last sync: the next record may share it.
+    size_t end = sizeof(Header) + used * sizeof(JournalRecord);
+    if (end > synced && syncRange(synced & ~(kPageBytes - 1), end))
+        synced = end;
+}
+
+bool Journal::syncRange(size_t from, size_t end)
+{
+    if (::sync_file_range(fd, static_cast<off_t>(from),
+                          static_cast<off_t>(end - from),
+                          SYNC_FILE_RANGE_WRITE) != 0)
+    {
+        std::cerr << "[Journal] sync failed: " << std::strerror(errno)
+                  << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::vector<JournalRecord> Journal::read(const std::string& path)
+{
+    std::vector<JournalRecord> out;
+    int rfd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (rfd < 0)
+        return out;
+
+    struct stat st{};
+    if (::fstat(rfd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Header))
+    {
+        ::close(rfd);
+        return out;
+    }
+
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, rfd, 0);
+    ::close(rfd);
+    if (p == MAP_FAILED)
+        return out;
+
+    const auto* mem = static_cast<const uint8_t*>(p);
+    Header h;
+    std::memcpy(&h, mem, sizeof(h));
+    if (headerValid(h))
+    {
+        size_t cap = std::min<size_t>(h.capacity, (bytes - sizeof(Header)) /
+                                                      sizeof(JournalRecord));
+        const uint8_t* records = mem + sizeof(Header);
+        size_t n = countValid(records, cap);
+        out.resize(n);
+        std::memcpy(out.data(), records, n * sizeof(JournalRecord));
+    }
+    ::munmap(p, bytes);
+    return out;
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/*
+ * Crash-safe experiment journal.
+ *
+ *   64-byte header: "PATJRNL" u8 version, u32 record size, u32 reserved,
+ *                   u64 capacity in records, zero padding
+ *   capacity fixed-size 64-byte records
+ *
+ * The file's blocks are reserved up front (posix_fallocate) and mapped,
+ * and open() zeroes the free slots, so append() is a copy into pages that
+ * are already dirty and the sample path never makes a syscall. Once
+ * write-back has cleaned a page, the next store to it takes a minor fault
+ * again, but never needs a block. Every record ends with a checksum over
+ * its bytes and slot number, stored after the rest of the record; reading
+ * stops at the first slot whose checksum does not match, so a record torn
+ * by a crash, or the zeroed tail, ends the journal.
+ *
+ * Mapped pages outlive a crashed process in the page cache. sync()
+ * (sync_file_range) only starts write-back of the records appended since
+ * the last call and waits for neither the data nor the file system's
+ * metadata, so it narrows what a power loss can cost without bounding it.
+ */
+
+enum class JournalKind : uint16_t
+{
+    Begin = 1, // time: wall-clock start (s since epoch), tag: config hash
+    Sample,    // channel, iteration, time, value: temp, aux: pwm
+    Phase,     // tag: new state, iteration, time, value/aux: phase data
+    Step,      // time: write issued, value: write acknowledged
+    Launch,    // scheduler: channel = experiment index
+    Done,      // scheduler: channel = experiment index
+};
+
+struct JournalRecord
+{
+    JournalKind kind{};
+    uint16_t channel = 0;
+    uint32_t reserved = 0;
+    int64_t iteration = 0;
+    double time = 0.0;
+    double value = 0.0;
+    double aux = 0.0;
+    uint64_t tag = 0;
+    uint64_t reserved2 = 0;
+    uint64_t check = 0;
+};
+
+static_assert(sizeof(JournalRecord) == 64);
+
+class Journal
+{
+  public:
+    Journal() = default;
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /**
+     * @brief Map @p path with room for @p capacity records.
+     * @param resume Keep the valid records already in the file and append
+     *        after them; otherwise start empty.
+     */
+    bool open(const std::string& path, size_t capacity, bool resume = false);
+
+    /** Unmap; the file stays for recovery. */
+    void close();
+
+    bool isOpen() const
+    {
+        return base != nullptr;
+    }
+
+    /** Copy one record in. @return false when closed or full. */
+    bool append(JournalRecord r);
+
+    /** Start writing the new records back without waiting. */
+    void sync();
+
+    size_t size() const
+    {
+        return used;
+    }
+
+    /** Valid records of a journal file; empty if missing or foreign. */
+    static std::vector<JournalRecord> read(const std::string& path);
+
+    /** Stable 64-bit hash (FNV-1a) for configuration tags. */
+    static uint64_t hash(std::string_view text);
+
+  private:
+    /** Start write-back of bytes [@p from, @p end) of the file. */
+    bool syncRange(size_t from, size_t end);
+
+    int fd = -1;
+    uint8_t* base = nullptr;
+    size_t mappedBytes = 0;
+    size_t capacity = 0;
+    size_t used = 0;
+    // End of the bytes handed to write-back so far.
+    size_t synced = 0;
+};
+
+} // namespace autotune::experiment
@@ -0,0 +1,213 @@
+#include "log_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace autotune::experiment
+{
+
+void CsvLogSink::header(std::string& out)
+{
+    out += "n,time,temp,pwm,slope,rmse,mean_temp\n";
+}
+
+void CsvLogSink::sample(const DataPoint& dp, std::string& out)
+{
+    // %g matches the default ostream formatting the log always used.
+    char line[192];
+    int len = std::snprintf(line, sizeof(line),
+                            "%" PRId64 ",%g,%g,%g,%g,%g,%g\n", dp.n, dp.time,
+                            dp.temp, dp.pwm, dp.slope, dp.rmse, dp.mean);
+    if (len > 0)
+        out.append(line, std::min<size_t>(len, sizeof(line) - 1));
+}
+
+void CsvLogSink::note(const std::string& text, std::string& out)
+{
+    out += text;
+    out += '\n';
+}
+
+LogWriter::LogWriter(LogPolicy policy) :
+    policy(policy), queue(policy.queueCapacity)
+{}
+
+LogWriter::~LogWriter()
+{
+    close();
+}
+
+bool LogWriter::open(const std::string& path, std::unique_ptr<LogSink> s,
+                     bool append)
+{
+    close();
+
+    int mode = append ? O_APPEND : O_TRUNC;
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | mode | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "[LogWriter] open " << path
+                  << " failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    sink = std::move(s);
+    writeHeader = !append;
+    stopping.store(false, std::memory_order_relaxed);
+    droppedSamples.store(0, std::memory_order_relaxed);
+    worker = std::thread([this] { run(); });
+    return true;
+}
+
+void LogWriter::close()
+{
+    if (!worker.joinable())
+        return;
+
+    stopping.store(true, std::memory_order_release);
+    wake();
+    worker.join();
+
+    ::close(fd);
+    fd = -1;
+    sink.reset();
+
+    if (auto n = dropped())
+        std::cerr << "[LogWriter] " << n << " samples dropped (queue full)\n";
+}
+
+void LogWriter::sample(const DataPoint& dp)
+{
+    if (!isOpen())
+        return;
+
+    Record r;
+    r.dp = dp;
+    if (!queue.tryPush(std::move(r)))
+        droppedSamples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LogWriter::note(std::string text)
+{
+    Record r;
+    r.kind = Record::Kind::Note;
+    r.text = std::move(text);
+    pushControl(std::move(r));
+}
+
+void LogWriter::sync()
+{
+    Record r;
+    r.kind = Record::Kind::Sync;
+    pushControl(std::move(r));
+    wake();
+}
+
+// Metadata and sync markers must not be dropped; wait for the writer to
+// make room instead. They are rare, so this never stalls the sample path.
+void LogWriter::pushControl(Record r)
+{
+    if (!isOpen())
+        return;
+
+    while (!queue.tryPush(r))
+    {
+        wake();
+        std::this_thread::yield();
+    }
+}
+
+void LogWriter::wake()
+{
+    {
+        std::lock_guard lock(wakeMutex);
+        wakeRequested = true;
+    }
+    wakeCv.notify_one();
+}
+
+static void writeAll(int fd, std::string& buf)
+{
+    size_t off = 0;
+    while (off < buf.size())
+    {
+        ssize_t n = ::write(fd, buf.data() + off, buf.size() - off);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "[LogWriter] write failed: " << std::strerror(errno)
+                      << "\n";
+            break;
+        }
+        off += static_cast<size_t>(n);
+    }
+    buf.clear();
+}
+
+void LogWriter::run()
+{
+    std::string buf;
+    buf.reserve(policy.flushBytes * 2);
+    if (writeHeader)
+        sink->header(buf);
+
+    auto lastFlush = std::chrono::steady_clock::now();
+    // Drain often enough that a burst never fills the queue, but batch
+    // writes on the configured policy.
+    auto drainPeriod =
+        std::min(policy.flushInterval, std::chrono::milliseconds(250));
+
+    for (;;)
+    {
+        // Read before draining: everything pushed before close() is then
+        // guaranteed to be seen below.
+        bool stop = stopping.load(std::memory_order_acquire);
+        bool syncRequested = false;
+
+        while (auto r = queue.tryPop())
+        {
+            switch (r->kind)
+            {
+                case Record::Kind::Sample:
+                    sink->sample(r->dp, buf);
+                    break;
+                case Record::Kind::Note:
+                    sink->note(r->text, buf);
+                    break;
+                case Record::Kind::Sync:
+                    syncRequested = true;
+                    break;
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        size_t buffered = buf.size() + sink->pending();
+        if (buffered > 0 &&
+            (stop || syncRequested || buffered >= policy.flushBytes ||
+             now - lastFlush >= policy.flushInterval))
+        {
+            sink->flush(buf);
+            writeAll(fd, buf);
+            lastFlush = now;
+        }
+
+        if (stop || syncRequested)
+            ::fsync(fd);
+
+        if (stop)
+            break;
+
+        std::unique_lock lock(wakeMutex);
+        wakeCv.wait_for(lock, drainPeriod, [this] { return wakeRequested; });
+        wakeRequested = false;
+    }
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../core/spsc_queue.hpp"
+#include "sample_store.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Serialises log records into bytes. Called only on the writer
+ *        thread.
+ */
+class LogSink
+{
+  public:
+    virtual ~LogSink() = default;
+
+    virtual void header(std::string& out) = 0;
+    virtual void sample(const DataPoint& dp, std::string& out) = 0;
+    virtual void note(const std::string& text, std::string& out) = 0;
+
+    /** Emit anything the sink is holding back; called before each write. */
+    virtual void flush(std::string& out)
+    {
+        (void)out;
+    }
+
+    /** Bytes held back by the sink, counted against the flush size. */
+    virtual size_t pending() const
+    {
+        return 0;
+    }
+};
+
+/** step_trigger_<sensor>.txt CSV layout. */
+class CsvLogSink : public LogSink
+{
+  public:
+    void header(std::string& out) override;
+    void sample(const DataPoint& dp, std::string& out) override;
+    void note(const std::string& text, std::string& out) override;
+};
+
+struct LogPolicy
+{
+    size_t flushBytes = 4096; // write once this much is buffered
+    std::chrono::milliseconds flushInterval{1000}; // or this long has passed
+    size_t queueCapacity = 1024;
+};
+
+/**
+ * @brief Moves log formatting and file I/O off the event loop.
+ *
+ * The experiment pushes records into a lock-free single-producer queue; a
+ * dedicated thread drains it, formats through the sink, and writes in
+ * batches on a size/time policy. sync() forces a write plus fsync (used on
+ * phase transitions); close() drains every queued record, fsyncs and joins
+ * the thread, so nothing accepted by sample() is lost on shutdown. Samples
+ * that find the queue full are counted in dropped().
+ */
+class LogWriter
+{
+  public:
+    explicit LogWriter(LogPolicy policy = {});
+    ~LogWriter();
+
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    /** @param append Continue an existing file (no header), e.g. when a
+     *         journaled run resumes after a restart. */
+    bool open(const std::string& path, std::unique_ptr<LogSink> sink,
+              bool append = false);
+    void close();
+
+    bool isOpen() const
+    {
+        return worker.joinable();
+    }
+
+    /** Queue one sample; never blocks. */
+    void sample(const DataPoint& dp);
+
+    /** Queue a free-form line (e.g. step metadata). */
+    void note(std::string text);
+
+    /** Write out everything queued so far and fsync. */
+    void sync();
+
+    size_t queueDepth() const
+    {
+        return queue.size();
+    }
+
+    uint64_t dropped() const
+    {
+        return droppedSamples.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Record
+    {
+        enum class Kind : uint8_t
+        {
+            Sample,
+            Note,
+            Sync
+        };
+
+        Kind kind = Kind::Sample;
+        DataPoint dp{};
+        std::string text;
+    };
+
+    void pushControl(Record r);
+    void wake();
+    void run();
+
+    LogPolicy policy;
+    core::SpscQueue<Record> queue;
+    std::unique_ptr<LogSink> sink;
+    int fd = -1;
+    bool writeHeader = true;
+
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> droppedSamples{0};
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool wakeRequested = false;
+};
+
+} // namespace autotune::experiment
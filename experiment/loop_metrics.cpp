@@ -0,0 +1,71 @@
+#include "loop_metrics.hpp"
+
+#include "../core/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace autotune::experiment
+{
+
+LoopMetrics computeLoopMetrics(std::span<const double> time,
+                               std::span<const double> temp,
+                               std::span<const double> duty, double stepTime,
+                               double start, double setpoint, double band)
+{
+    LoopMetrics m;
+    double change = setpoint - start;
+    if (time.size() != temp.size() || time.size() != duty.size() ||
+        std::abs(change) < 1e-9)
+        return m;
+
+    size_t first = static_cast<size_t>(
+        std::lower_bound(time.begin(), time.end(), stepTime) - time.begin());
+    if (time.size() - first < 2)
+        return m;
+
+    double t10 = -1.0;
+    double t90 = -1.0;
+    double peak = 0.0;
+    size_t lastOutside = time.size();
+    double dutySum = 0.0;
+    for (size_t i = first; i < time.size(); ++i)
+    {
+        double progress = (temp[i] - start) / change;
+        peak = std::max(peak, progress);
+
+        if (i > first)
+        {
+            double p0 = (temp[i - 1] - start) / change;
+            if (t10 < 0 && p0 < 0.1 && progress >= 0.1)
+                t10 = core::linearInterpolateX(0.1, time[i - 1], p0, time[i],
+                                               progress);
+            if (t90 < 0 && p0 < 0.9 && progress >= 0.9)
+                t90 = core::linearInterpolateX(0.9, time[i - 1], p0, time[i],
+                                               progress);
+
+            double dt = time[i] - time[i - 1];
+            m.iae += 0.5 * dt *
+                     (std::abs(setpoint - temp[i]) +
+                      std::abs(setpoint - temp[i - 1]));
+            m.effort += std::abs(duty[i] - duty[i - 1]);
+        }
+
+        if (std::abs(temp[i] - setpoint) > band)
+            lastOutside = i;
+        dutySum += duty[i];
+    }
+
+    if (t10 >= 0 && t90 >= 0)
+        m.riseTime = t90 - t10;
+    m.overshoot = std::max(0.0, peak - 1.0) * 100.0;
+    if (lastOutside == time.size())
+        m.settlingTime = 0.0;
+    else if (lastOutside + 1 < time.size())
+        m.settlingTime = time[lastOutside + 1] - stepTime;
+    m.meanDuty = dutySum / static_cast<double>(time.size() - first);
+    m.valid = true;
+    return m;
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <span>
+
+namespace autotune::experiment
+{
+
+/** Closed-loop response to one setpoint change. */
+struct LoopMetrics
+{
+    double riseTime = -1.0;     // s, 10% to 90% of the change; -1 if not
+    double overshoot = 0.0;     // % of the change
+    double settlingTime = -1.0; // s until it stays in the band; -1 if not
+    double iae = 0.0;           // integral of |error|, degC*s
+    double effort = 0.0;        // total duty movement, percent
+    double meanDuty = 0.0;      // percent
+    bool valid = false;
+};
+
+/**
+ * @brief Score a setpoint change from @p start to @p setpoint at
+ *        @p stepTime.
+ * @param duty Controller output per sample, duty percent
+ * @param band Settling band around the setpoint, degC
+ */
+LoopMetrics computeLoopMetrics(std::span<const double> time,
+                               std::span<const double> temp,
+                               std::span<const double> duty, double stepTime,
+                               double start, double setpoint, double band);
+
+} // namespace autotune::experiment
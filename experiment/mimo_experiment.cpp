@@ -0,0 +1,255 @@
+#include "mimo_experiment.hpp"
+
+#include "../core/utils.hpp"
+#include "../process_models/fopdt.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace autotune::experiment
+{
+
+MimoExperiment::MimoExperiment(boost::asio::io_context& io,
+                               core::ThreadPool& analysisPool,
+                               const config::BasicSetting& basic,
+                               const config::MimoConfig& cfg) :
+    PollingExperiment(io, analysisPool, basic, "Mimo", "mimo",
+                      cfg.sensors.size()),
+    cfg(cfg), stats(cfg.sensors.size(),
+                    core::RollingStats(static_cast<size_t>(
+                        std::max(basic.windowSize, 1))))
+{}
+
+std::vector<std::string> MimoExperiment::fans() const
+{
+    std::vector<std::string> all;
+    for (const auto& g : cfg.fanGroups)
+        all.insert(all.end(), g.fans.begin(), g.fans.end());
+    return all;
+}
+
+int64_t MimoExperiment::totalIterations() const
+{
+    int64_t groups = static_cast<int64_t>(cfg.fanGroups.size());
+    return std::max<int64_t>(cfg.settleIterations, 0) +
+           std::max<int64_t>(groups - 1, 0) *
+               std::max<int64_t>(cfg.stepInterval, 0) +
+           std::max<int64_t>(cfg.holdIterations, 0);
+}
+
+double MimoExperiment::progress() const
+{
+    int64_t total = totalIterations();
+    if (total <= 0)
+        return 0.0;
+    return std::min(1.0, static_cast<double>(currentIteration) / total);
+}
+
+bool MimoExperiment::beginRun()
+{
+    if (cfg.fanGroups.empty() || cfg.sensors.empty())
+    {
+        std::cerr << "[Mimo] " << cfg.name
+                  << " needs at least one fan group and one sensor\n";
+        return false;
+    }
+
+    nextGroup = 0;
+    stepTimes.assign(cfg.fanGroups.size(), -1.0);
+    baselines.assign(cfg.sensors.size(), 0.0);
+    for (auto& s : stats)
+        s.reset();
+    samples.reset(static_cast<size_t>(totalIterations()), cfg.sensors.size(),
+                  basicCfg.compactStorage);
+
+    writePwm(fans(), cfg.basePwmDuty);
+    return true;
+}
+
+std::string MimoExperiment::logMetadata(const std::string& sensor) const
+{
+    nlohmann::json j;
+    j["tempsensor"] = sensor;
+    j["mimo"] = cfg.name;
+    j["pollinterval"] = basicCfg.pollInterval;
+    j["windowsize"] = basicCfg.windowSize;
+    j["basepwmduty"] = cfg.basePwmDuty;
+    j["steppwmduty"] = cfg.stepPwmDuty;
+    nlohmann::json groups = nlohmann::json::array();
+    for (const auto& g : cfg.fanGroups)
+        groups.push_back({{"name", g.name}, {"fans", g.fans}});
+    j["fangroups"] = groups;
+    j["settleiterations"] = cfg.settleIterations;
+    j["stepinterval"] = cfg.stepInterval;
+    j["holditerations"] = cfg.holdIterations;
+    return j.dump();
+}
+
+void MimoExperiment::recordSample(
+    const std::vector<std::optional<double>>& temps, double timestamp)
+{
+    // The sample store keeps every channel of a poll in one row, so a poll
+    // with a failed read is dropped whole rather than filled in.
+    for (size_t i = 0; i < temps.size(); ++i)
+    {
+        if (!temps[i])
+        {
+            std::cerr << "[Mimo] " << cfg.name << " read of "
+                      << cfg.sensors[i] << " failed, sample skipped\n";
+            return;
+        }
+    }
+
+    // Duty of the most recently stepped group.
+    double pwm = nextGroup > 0 ? cfg.stepPwmDuty : cfg.basePwmDuty;
+
+    channelValues.resize(temps.size());
+    for (size_t i = 0; i < temps.size(); ++i)
+    {
+        auto& st = stats[i];
+        auto& cv = channelValues[i];
+        cv.temp = *temps[i];
+        st.push(timestamp, cv.temp);
+        cv.slope = st.slope();
+        cv.rmse = st.rmse();
+        cv.mean = st.mean();
+        logWriters[i]->sample(DataPoint{currentIteration, timestamp, cv.temp,
+                                        pwm, cv.slope, cv.rmse, cv.mean});
+    }
+
+    if (!samples.append(timestamp, pwm, channelValues))
+    {
+        std::cerr << "[Mimo] Sample store full for " << cfg.name
+                  << ", sample " << currentIteration << " not kept\n";
+    }
+
+    currentIteration++;
+
+    int64_t nextStepAt = std::max<int64_t>(cfg.settleIterations, 0) +
+                         static_cast<int64_t>(nextGroup) *
+                             std::max<int64_t>(cfg.stepInterval, 0);
+    if (nextGroup < cfg.fanGroups.size() && currentIteration >= nextStepAt)
+        stepGroup(nextGroup++, timestamp);
+
+    if (currentIteration >= totalIterations())
+    {
+        std::cout << "[Mimo] Finished " << cfg.name << "\n";
+        submitAnalysis();
+    }
+}
+
+void MimoExperiment::stepGroup(size_t group, double time)
+{
+    const auto& g = cfg.fanGroups[group];
+    std::cerr << "[Mimo] " << cfg.name << " stepping group " << g.name
+              << " to " << cfg.stepPwmDuty << "\n";
+
+    if (group == 0)
+    {
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            baselines[i] = stats[i].full() ? stats[i].mean()
+                                           : channelValues[i].temp;
+        }
+        logSync();
+    }
+
+    // Refined to the write's issue time once it completes.
+    stepTimes[group] = time;
+
+    auto weak = weakSelf(this);
+    uint64_t id = runId;
+    writePwm(g.fans, cfg.stepPwmDuty,
+             [weak, id, group](const io::WriteResult& result) {
+                 auto self = weak.lock();
+                 if (!self || self->runId != id)
+                     return;
+                 std::chrono::duration<double> issued =
+                     result.issued - self->startTime;
+                 std::chrono::duration<double> acked =
+                     result.acked - self->startTime;
+                 self->stepTimes[group] = issued.count();
+
+                 std::ostringstream line;
+                 line << "#group_step=" << self->cfg.fanGroups[group].name
+                      << ",step_issued=" << issued.count()
+                      << ",step_acked=" << acked.count();
+                 self->logNote(line.str());
+             });
+}
+
+// The sensors are fitted in parallel, each with every group's FOPDT,
+// then the coupling matrix is written.
+void MimoExperiment::submitAnalysis()
+{
+    struct Job
+    {
+        std::string name;
+        std::string path;
+        std::vector<std::string> groups;
+        std::vector<std::string> sensors;
+        std::shared_ptr<const SampleStore> samples;
+        std::vector<process_models::StepInput> steps;
+        std::vector<double> baselines;
+        // rows[sensor][group]
+        std::vector<std::vector<process_models::StepSequenceFit>> rows;
+    };
+
+    auto job = std::make_shared<Job>();
+    job->name = cfg.name;
+    job->path = logDir + "/coupling_" + cfg.name + ".json";
+    for (const auto& g : cfg.fanGroups)
+        job->groups.push_back(g.name);
+    job->sensors = cfg.sensors;
+    job->samples = std::make_shared<const SampleStore>(std::move(samples));
+    job->baselines = baselines;
+    job->rows.resize(cfg.sensors.size());
+
+    double dutyChange =
+        core::scaleRawToDuty(static_cast<int>(cfg.stepPwmDuty)) -
+        core::scaleRawToDuty(static_cast<int>(cfg.basePwmDuty));
+    for (size_t g = 0; g < nextGroup; ++g)
+        job->steps.push_back({stepTimes[g], dutyChange});
+
+    endRun([job, &pool = analysisPool] {
+        pool.parallelFor(job->sensors.size(), [&job](size_t ch) {
+            job->rows[ch] = process_models::identifyStepSequence(
+                job->samples->times(), job->samples->temps(ch), job->steps,
+                job->baselines[ch]);
+        });
+
+        nlohmann::json j;
+        j["name"] = job->name;
+        j["fangroups"] = job->groups;
+        j["sensors"] = job->sensors;
+        for (const char* key : {"k", "tau", "theta"})
+            j[key] = nlohmann::json::array();
+        for (const auto& row : job->rows)
+        {
+            nlohmann::json k = nlohmann::json::array();
+            nlohmann::json tau = nlohmann::json::array();
+            nlohmann::json theta = nlohmann::json::array();
+            // Entries the record could not resolve are null.
+            for (const auto& fit : row)
+            {
+                auto entry = [&fit](double v) {
+                    return fit.valid ? nlohmann::json(v) : nlohmann::json();
+                };
+                k.push_back(entry(fit.params.k));
+                tau.push_back(entry(fit.params.tau));
+                theta.push_back(entry(fit.params.theta));
+            }
+            j["k"].push_back(k);
+            j["tau"].push_back(tau);
+            j["theta"].push_back(theta);
+        }
+        std::ofstream out(job->path);
+        out << j.dump(4) << "\n";
+    });
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "../core/rolling_stats.hpp"
+#include "../core/thread_pool.hpp"
+#include "polling_experiment.hpp"
+#include "sample_store.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Fan-zone coupling experiment.
+ *
+ * Holds every fan group at the base duty for settleIterations, then steps
+ * the groups to the step duty one after another, stepInterval samples
+ * apart, and keeps recording for holdIterations after the last step. All
+ * configured sensors are sampled together. Afterwards each sensor's record
+ * is fitted with one FOPDT per group (superposed, so overlapping steps are
+ * allowed) and the sensors x groups k/tau/theta matrix is written to
+ * coupling_<name>.json.
+ */
+class MimoExperiment : public PollingExperiment
+{
+  public:
+    MimoExperiment(boost::asio::io_context& io,
+                   core::ThreadPool& analysisPool,
+                   const config::BasicSetting& basic,
+                   const config::MimoConfig& cfg);
+
+    const std::string& name() const override
+    {
+        return cfg.name;
+    }
+
+    double progress() const override;
+    std::vector<std::string> fans() const override;
+
+    const std::vector<std::string>& sensors() const override
+    {
+        return cfg.sensors;
+    }
+
+    const std::vector<std::string>& coupledSensors() const override
+    {
+        return cfg.coupledSensors;
+    }
+
+    int priority() const override
+    {
+        return cfg.priority;
+    }
+
+  private:
+    bool beginRun() override;
+    void recordSample(const std::vector<std::optional<double>>& temps,
+                      double timestamp) override;
+    std::string logMetadata(const std::string& sensor) const override;
+    void stepGroup(size_t group, double time);
+    int64_t totalIterations() const;
+    void submitAnalysis();
+
+    config::MimoConfig cfg;
+
+    size_t nextGroup = 0;
+    // Per group: when its step went out, relative to startTime.
+    std::vector<double> stepTimes;
+    // Per sensor: mean temperature just before the first step.
+    std::vector<double> baselines;
+
+    std::vector<core::RollingStats> stats;
+    SampleStore samples;
+    std::vector<ChannelSample> channelValues; // scratch for recordSample
+};
+
+} // namespace autotune::experiment
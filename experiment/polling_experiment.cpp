@@ -0,0 +1,191 @@
+#include "polling_experiment.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <filesystem>
+#include <iostream>
+
+namespace autotune::experiment
+{
+
+namespace fs = std::filesystem;
+
+PollingExperiment::PollingExperiment(boost::asio::io_context& io,
+                                     core::ThreadPool& analysisPool,
+                                     const config::BasicSetting& basic,
+                                     std::string tag, std::string logPrefix,
+                                     size_t logs) :
+    io(io), analysisPool(analysisPool), basicCfg(basic), tag(std::move(tag)),
+    logPrefix(std::move(logPrefix))
+{
+    for (size_t i = 0; i < logs; ++i)
+        logWriters.push_back(makeLogWriter(basicCfg));
+}
+
+size_t PollingExperiment::logQueueDepth() const
+{
+    size_t depth = 0;
+    for (const auto& w : logWriters)
+        depth += w->queueDepth();
+    return depth;
+}
+
+uint64_t PollingExperiment::logDropped() const
+{
+    uint64_t n = 0;
+    for (const auto& w : logWriters)
+        n += w->dropped();
+    return n;
+}
+
+void PollingExperiment::setEnabled(bool enable)
+{
+    if (enabled == enable)
+        return;
+    enabled = enable;
+    if (enabled)
+        start();
+    else
+        stop();
+}
+
+void PollingExperiment::start()
+{
+    if (running)
+        return;
+
+    readInFlight = false;
+    runId++;
+    currentIteration = 0;
+    startTime = std::chrono::steady_clock::now();
+    lastTickTime = startTime;
+    if (!beginRun())
+    {
+        enabled = false;
+        return;
+    }
+    running = true;
+
+    logDir = "/var/lib/phosphor-pid-autotune/log/" + name();
+    std::cerr << "[" << tag << "] Starting " << name() << " LogDir: " << logDir
+              << "\n";
+    try
+    {
+        fs::create_directories(logDir);
+    }
+    catch (const fs::filesystem_error& e)
+    {
+        std::cerr << "Error creating log dir: " << e.what() << "\n";
+    }
+
+    const auto& sensorNames = sensors();
+    for (size_t i = 0; i < logWriters.size(); ++i)
+    {
+        const auto& sensor = sensorNames[i];
+        openLog(*logWriters[i], logDir + "/" + logPrefix + "_" + sensor,
+                logMetadata(sensor), basicCfg);
+    }
+}
+
+void PollingExperiment::stop()
+{
+    running = false;
+    io::backend().releasePwm(fans());
+    for (auto& w : logWriters)
+        w->close();
+}
+
+void PollingExperiment::tick()
+{
+    if (!running || readInFlight)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastTickTime;
+    if (elapsed.count() < basicCfg.pollInterval)
+        return;
+    lastTickTime = now;
+
+    iteration();
+}
+
+void PollingExperiment::iteration()
+{
+    readInFlight = true;
+    std::weak_ptr<PollingExperiment> weak = weak_from_this();
+    uint64_t id = runId;
+
+    io::backend().readTempsC(
+        sensors(),
+        [weak, id](std::vector<std::optional<double>> temps,
+                   std::chrono::steady_clock::time_point completed) {
+            auto self = weak.lock();
+            if (!self || self->runId != id)
+                return;
+            self->readInFlight = false;
+            if (!self->running)
+                return;
+            std::chrono::duration<double> sinceStart =
+                completed - self->startTime;
+            self->recordSample(temps, sinceStart.count());
+        });
+}
+
+void PollingExperiment::writePwm(const std::vector<std::string>& fans,
+                                 double duty, io::WriteHandler onDone)
+{
+    std::string prefix = "[" + tag + "] PWM write failed for " + name();
+    io::backend().writePwm(
+        fans, static_cast<int>(duty),
+        [prefix, onDone](const io::WriteResult& result) {
+            if (!result.ok)
+                std::cerr << prefix << "\n";
+            if (onDone)
+                onDone(result);
+        });
+}
+
+void PollingExperiment::logNote(const std::string& text)
+{
+    for (auto& w : logWriters)
+        w->note(text);
+}
+
+void PollingExperiment::logSync()
+{
+    for (auto& w : logWriters)
+        w->sync();
+}
+
+void PollingExperiment::endRun(std::function<void()> analyse)
+{
+    // The writers drain and fsync on a worker; the next run gets fresh ones.
+    auto writers = std::make_shared<std::vector<std::unique_ptr<LogWriter>>>(
+        std::move(logWriters));
+    logWriters.clear();
+    for (size_t i = 0; i < writers->size(); ++i)
+        logWriters.push_back(makeLogWriter(basicCfg));
+
+    uint64_t id = beginAnalysis();
+    std::weak_ptr<PollingExperiment> weak = weak_from_this();
+    auto post = [&ioc = io, weak, id](AnalysisStatus status) {
+        boost::asio::post(ioc, [weak, id, status] {
+            if (auto self = weak.lock())
+                self->setAnalysisStatus(id, status);
+        });
+    };
+
+    analysisPool.submit([writers, post, analyse = std::move(analyse)] {
+        post(AnalysisStatus::Running);
+        for (auto& w : *writers)
+            w->close();
+        analyse();
+        post(AnalysisStatus::Done);
+    });
+
+    enabled = false;
+    running = false;
+    io::backend().releasePwm(fans());
+}
+
+} // namespace autotune::experiment
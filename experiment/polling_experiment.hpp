@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "../core/backend.hpp"
+#include "../core/thread_pool.hpp"
+#include "experiment.hpp"
+#include "log_writer.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Base of the experiments that poll their sensors() at the poll
+ *        interval and hand the finished record to one analysis job.
+ *
+ * It owns enabling, the poll and its run guard, the log directory with one
+ * sample log per sensor (<logDir>/<logPrefix>_<sensor>) and the hand-off
+ * to the analysis pool, and releases the fans (io::Backend::releasePwm)
+ * whenever a run stops or ends. A subclass resets its state in beginRun(),
+ * reacts to every poll in recordSample() and calls endRun() with its
+ * analysis.
+ */
+class PollingExperiment :
+    public Experiment,
+    public std::enable_shared_from_this<PollingExperiment>
+{
+  public:
+    void tick() override;
+    void setEnabled(bool enabled) override;
+    bool getEnabled() const override
+    {
+        return enabled;
+    }
+
+    size_t logQueueDepth() const override;
+    uint64_t logDropped() const override;
+
+  protected:
+    /**
+     * @param tag       Prefix of console messages, e.g. "Relay"
+     * @param logPrefix Sample logs are <logDir>/<logPrefix>_<sensor>
+     * @param logs      Number of sensors, one log each
+     */
+    PollingExperiment(boost::asio::io_context& io,
+                      core::ThreadPool& analysisPool,
+                      const config::BasicSetting& basic, std::string tag,
+                      std::string logPrefix, size_t logs);
+
+    /**
+     * @brief Reset per-run state and drive the fans to their starting
+     *        duty; false refuses the run (after logging why).
+     */
+    virtual bool beginRun() = 0;
+
+    /**
+     * @brief One poll of sensors(), in order, nullopt where a read failed;
+     *        @p time is in seconds since the run started.
+     */
+    virtual void recordSample(const std::vector<std::optional<double>>& temps,
+                              double time) = 0;
+
+    virtual std::string logMetadata(const std::string& sensor) const = 0;
+
+    /**
+     * @brief End the run and run @p analyse on the analysis pool, after the
+     *        run's logs are drained and fsynced there.
+     */
+    void endRun(std::function<void()> analyse);
+
+    void writePwm(const std::vector<std::string>& fans, double duty,
+                  io::WriteHandler onDone = nullptr);
+
+    /** Note in every sample log. */
+    void logNote(const std::string& text);
+
+    /** Make every sample log durable up to now, e.g. before a step. */
+    void logSync();
+
+    /** Weak reference to this experiment as its concrete type. */
+    template <typename Self>
+    std::weak_ptr<Self> weakSelf(Self*)
+    {
+        return std::static_pointer_cast<Self>(weak_from_this().lock());
+    }
+
+    boost::asio::io_context& io;
+    core::ThreadPool& analysisPool;
+    config::BasicSetting basicCfg;
+    std::string tag;
+
+    bool running = false;
+    // Bumped on every start so completions from a previous run are ignored.
+    uint64_t runId = 0;
+    int64_t currentIteration = 0;
+    std::chrono::time_point<std::chrono::steady_clock> startTime;
+
+    std::string logDir;
+    std::vector<std::unique_ptr<LogWriter>> logWriters;
+
+  private:
+    void start();
+    void stop();
+    void iteration();
+
+    std::string logPrefix;
+    bool enabled = false;
+    // A sensor read is outstanding; the next poll waits for it.
+    bool readInFlight = false;
+    std::chrono::time_point<std::chrono::steady_clock> lastTickTime;
+};
+
+} // namespace autotune::experiment
@@ -0,0 +1,222 @@
+#include "relay_experiment.hpp"
+
+#include "../core/utils.hpp"
+#include "../process_models/pid_tuning.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace autotune::experiment
+{
+
+RelayExperiment::RelayExperiment(boost::asio::io_context& io,
+                                 core::ThreadPool& analysisPool,
+                                 const config::BasicSetting& basic,
+                                 const config::RelayConfig& cfg) :
+    PollingExperiment(io, analysisPool, basic, "Relay", "relay", 1),
+    cfg(cfg), sensorList{cfg.tempSensor},
+    stats(static_cast<size_t>(std::max(basic.windowSize, 1)))
+{}
+
+double RelayExperiment::midDuty() const
+{
+    return (cfg.highPwmDuty + cfg.lowPwmDuty) / 2.0;
+}
+
+double RelayExperiment::progress() const
+{
+    int64_t total = std::max(cfg.settleIterations, 0) +
+                    std::max(cfg.maxIterations, 0);
+    if (total <= 0)
+        return 0.0;
+    return std::min(1.0, static_cast<double>(currentIteration) / total);
+}
+
+bool RelayExperiment::beginRun()
+{
+    relayStart = 0;
+    phase = Phase::Settle;
+    relayHigh = false;
+    stats.reset();
+    tracker.reset();
+
+    writeDuty(midDuty());
+    return true;
+}
+
+std::string RelayExperiment::logMetadata(const std::string&) const
+{
+    nlohmann::json j;
+    j["tempsensor"] = cfg.tempSensor;
+    j["relay"] = cfg.name;
+    j["pollinterval"] = basicCfg.pollInterval;
+    j["windowsize"] = basicCfg.windowSize;
+    j["fans"] = cfg.fans;
+    j["highpwmduty"] = cfg.highPwmDuty;
+    j["lowpwmduty"] = cfg.lowPwmDuty;
+    j["hysteresis"] = cfg.hysteresis;
+    if (cfg.setpoint)
+        j["setpoint"] = *cfg.setpoint;
+    j["settleiterations"] = cfg.settleIterations;
+    j["maxiterations"] = cfg.maxIterations;
+    return j.dump();
+}
+
+void RelayExperiment::writeDuty(double duty)
+{
+    currentDuty = duty;
+    writePwm(cfg.fans, duty);
+}
+
+void RelayExperiment::recordSample(
+    const std::vector<std::optional<double>>& temps, double timestamp)
+{
+    if (!temps.front())
+    {
+        // A made-up reading would switch the relay and distort the cycle
+        // extremes and the settle mean behind the setpoint.
+        std::cerr << "[Relay] " << cfg.name
+                  << " read failed, holding relay\n";
+        return;
+    }
+    double temp = *temps.front();
+    stats.push(timestamp, temp);
+    logWriters.front()->sample(DataPoint{currentIteration, timestamp, temp,
+                                         currentDuty, stats.slope(),
+                                         stats.rmse(), stats.mean()});
+    currentIteration++;
+
+    if (phase == Phase::Settle)
+    {
+        if (currentIteration >= cfg.settleIterations)
+            startRelay(timestamp, temp);
+        return;
+    }
+
+    // Cooling relay: more fan when hot.
+    if (!relayHigh && temp > setpoint + cfg.hysteresis)
+        setRelay(true);
+    else if (relayHigh && temp < setpoint - cfg.hysteresis)
+        setRelay(false);
+    tracker.update(timestamp, temp, relayHigh);
+
+    size_t need = static_cast<size_t>(std::max(cfg.cycles, 1));
+    if (tracker.stable(need, cfg.cycleTolerance))
+        finish("stable");
+    else if (currentIteration - relayStart >= cfg.maxIterations)
+        finish("limit");
+}
+
+void RelayExperiment::startRelay(double time, double temp)
+{
+    setpoint = cfg.setpoint.value_or(stats.full() ? stats.mean() : temp);
+    relayStart = currentIteration;
+    phase = Phase::Relay;
+
+    std::cerr << "[Relay] " << cfg.name << " relay started, setpoint "
+              << setpoint << "\n";
+    std::ostringstream line;
+    line << "#relay_start=" << time << ",setpoint=" << setpoint
+         << ",hysteresis=" << cfg.hysteresis;
+    logNote(line.str());
+    logSync();
+
+    // Start on the side that pulls the temperature back to the setpoint.
+    setRelay(temp > setpoint);
+}
+
+void RelayExperiment::setRelay(bool high)
+{
+    relayHigh = high;
+    writeDuty(high ? cfg.highPwmDuty : cfg.lowPwmDuty);
+}
+
+void RelayExperiment::finish(const char* reason)
+{
+    std::cout << "[Relay] Finished " << cfg.name << " (" << reason << ")\n";
+    writeDuty(midDuty());
+
+    struct Report
+    {
+        std::string path;
+        std::string name;
+        std::string reason;
+        double setpoint;
+        double hysteresis;
+        std::optional<process_models::RelayOscillation> osc;
+        process_models::RelayIdentification id;
+    };
+
+    auto report = std::make_shared<Report>();
+    report->path = logDir + "/relay_" + cfg.name + ".txt";
+    report->name = cfg.name;
+    report->reason = reason;
+    report->setpoint = setpoint;
+    report->hysteresis = cfg.hysteresis;
+
+    size_t need = static_cast<size_t>(std::max(cfg.cycles, 1));
+    report->osc = tracker.measure(std::min(need, tracker.cycles()));
+    if (report->osc)
+    {
+        double d = (core::scaleRawToDuty(static_cast<int>(cfg.highPwmDuty)) -
+                    core::scaleRawToDuty(static_cast<int>(cfg.lowPwmDuty))) /
+                   2.0;
+        // More fan lowers the temperature.
+        report->id = process_models::identifyRelay(*report->osc, d,
+                                                   cfg.hysteresis, -1.0);
+    }
+
+    std::ostringstream line;
+    line << "#relay_end=" << reason << ",cycles=" << tracker.cycles();
+    logNote(line.str());
+
+    endRun([report] {
+        std::ofstream out(report->path);
+        out << "Name:" << report->name << "\n";
+        out << "End=" << report->reason << "\n";
+        out << "Setpoint=" << report->setpoint << "\n";
+        out << "Hysteresis=" << report->hysteresis << "\n";
+        if (report->osc)
+        {
+            const auto& osc = *report->osc;
+            const auto& rid = report->id;
+            out << "Cycles=" << osc.cycles << "\n";
+            out << "Period=" << osc.period << "\n";
+            out << "Amplitude=" << osc.amplitude << "\n";
+            out << "DeadTime=" << osc.deadTime << "\n\n";
+
+            out << "------Ultimate Point--------\n";
+            out << "Ku=" << rid.ku << "\n";
+            out << "Pu=" << rid.pu << "\n\n";
+
+            auto pid = process_models::zieglerNicholsPID(rid.ku, rid.pu, -1.0);
+            out << "------Ziegler-Nichols PID--------\n";
+            out << "kp=" << pid.kp << "\n";
+            out << "ki=" << pid.ki << "\n";
+            out << "kd=" << pid.kd << "\n\n";
+
+            auto pi = process_models::zieglerNicholsPI(rid.ku, rid.pu, -1.0);
+            out << "------Ziegler-Nichols PI--------\n";
+            out << "kp=" << pi.kp << "\n";
+            out << "ki=" << pi.ki << "\n\n";
+
+            if (rid.fopdtValid)
+            {
+                out << "------FOPDT from Relay--------\n";
+                out << "k=" << rid.fopdt.k << "\n";
+                out << "tau=" << rid.fopdt.tau << "\n";
+                out << "theta=" << rid.fopdt.theta << "\n";
+            }
+        }
+        else
+        {
+            out << "Cycles=0\n";
+        }
+    });
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "../core/rolling_stats.hpp"
+#include "../core/thread_pool.hpp"
+#include "../process_models/relay.hpp"
+#include "polling_experiment.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Relay-feedback (Astrom-Hagglund) autotune.
+ *
+ * Holds the fans at the mid duty for settleIterations (the mean at the end
+ * becomes the setpoint unless one is configured), then drives them to the
+ * high duty whenever the temperature rises above setpoint + hysteresis
+ * and to the low duty when it falls below setpoint - hysteresis. Once the
+ * last @c cycles periods and amplitudes agree within cycleTolerance, or
+ * maxIterations is reached, the fans go back to the mid duty and the
+ * ultimate gain/period, Ziegler-Nichols gains and an FOPDT estimate are
+ * written to relay_<name>.txt.
+ */
+class RelayExperiment : public PollingExperiment
+{
+  public:
+    RelayExperiment(boost::asio::io_context& io,
+                    core::ThreadPool& analysisPool,
+                    const config::BasicSetting& basic,
+                    const config::RelayConfig& cfg);
+
+    const std::string& name() const override
+    {
+        return cfg.name;
+    }
+
+    double progress() const override;
+
+    std::vector<std::string> fans() const override
+    {
+        return cfg.fans;
+    }
+
+    const std::vector<std::string>& sensors() const override
+    {
+        return sensorList;
+    }
+
+    const std::vector<std::string>& coupledSensors() const override
+    {
+        return cfg.coupledSensors;
+    }
+
+    int priority() const override
+    {
+        return cfg.priority;
+    }
+
+  private:
+    enum class Phase
+    {
+        Settle,
+        Relay
+    };
+
+    bool beginRun() override;
+    void recordSample(const std::vector<std::optional<double>>& temps,
+                      double timestamp) override;
+    std::string logMetadata(const std::string& sensor) const override;
+    void startRelay(double time, double temp);
+    void setRelay(bool high);
+    void finish(const char* reason);
+    void writeDuty(double duty);
+    double midDuty() const;
+
+    config::RelayConfig cfg;
+    std::vector<std::string> sensorList;
+
+    int64_t relayStart = 0;
+    Phase phase = Phase::Settle;
+    double setpoint = 0.0;
+    bool relayHigh = false;
+    double currentDuty = 0.0;
+
+    core::RollingStats stats;
+    process_models::RelayCycleTracker tracker;
+};
+
+} // namespace autotune::experiment
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+struct DataPoint
+{
+    int64_t n;
+    double time;
+    double temp;
+    double pwm;
+    double slope;
+    double rmse;
+    double mean;
+};
+
+/** Per-sensor values of one sample. */
+struct ChannelSample
+{
+    double temp;
+    double slope;
+    double rmse;
+    double mean;
+};
+
+/**
+ * @brief Struct-of-arrays sample log for one experiment.
+ *
+ * Time and pwm are shared by every observed sensor (channel); each channel
+ * has its own temperature and derived columns. All columns are reserved up
+ * front from the experiment's iteration budget and never grow afterwards;
+ * appends past capacity are refused. Time and temperature stay double so
+ * the identifiers read them in place. The derived columns (pwm, slope,
+ * rmse, mean) are stored as float32 when @p compact is set. The sample
+ * index doubles as the iteration number.
+ */
+class SampleStore
+{
+  public:
+    void reset(size_t capacity, size_t channels, bool compact)
+    {
+        timeCol.clear();
+        timeCol.reserve(capacity);
+        pwmCol.reset(capacity, compact);
+        chans.resize(channels);
+        for (auto& ch : chans)
+        {
+            ch.temp.clear();
+            ch.temp.reserve(capacity);
+            for (auto* c : {&ch.slope, &ch.rmse, &ch.mean})
+                c->reset(capacity, compact);
+        }
+        cap = capacity;
+    }
+
+    /**
+     * @param values One entry per channel.
+     * @return false if the store is full and the sample was dropped.
+     */
+    bool append(double time, double pwm, std::span<const ChannelSample> values)
+    {
+        if (timeCol.size() >= cap || values.size() != chans.size())
+            return false;
+        timeCol.push_back(time);
+        pwmCol.push(pwm);
+        for (size_t i = 0; i < chans.size(); ++i)
+        {
+            chans[i].temp.push_back(values[i].temp);
+            chans[i].slope.push(values[i].slope);
+            chans[i].rmse.push(values[i].rmse);
+            chans[i].mean.push(values[i].mean);
+        }
+        return true;
+    }
+
+    size_t size() const
+    {
+        return timeCol.size();
+    }
+
+    bool empty() const
+    {
+        return timeCol.empty();
+    }
+
+    size_t channels() const
+    {
+        return chans.size();
+    }
+
+    std::span<const double> times() const
+    {
+        return timeCol;
+    }
+
+    std::span<const double> temps(size_t ch = 0) const
+    {
+        return chans[ch].temp;
+    }
+
+    DataPoint at(size_t i, size_t ch = 0) const
+    {
+        const auto& c = chans[ch];
+        return DataPoint{static_cast<int64_t>(i), timeCol[i], c.temp[i],
+                         pwmCol[i], c.slope[i], c.rmse[i], c.mean[i]};
+    }
+
+    DataPoint back(size_t ch = 0) const
+    {
+        return at(size() - 1, ch);
+    }
+
+  private:
+    // A derived column held as either float or double.
+    class Column
+    {
+      public:
+        void reset(size_t capacity, bool useFloat)
+        {
+            compact = useFloat;
+            f.clear();
+            d.clear();
+            if (compact)
+            {
+                f.reserve(capacity);
+                d.shrink_to_fit();
+            }
+            else
+            {
+                d.reserve(capacity);
+                f.shrink_to_fit();
+            }
+        }
+
+        void push(double v)
+        {
+            if (compact)
+                f.push_back(static_cast<float>(v));
+            else
+                d.push_back(v);
+        }
+
+        double operator[](size_t i) const
+        {
+            return compact ? static_cast<double>(f[i]) : d[i];
+        }
+
+      private:
+        bool compact = false;
+        std::vector<float> f;
+        std::vector<double> d;
+    };
+
+    struct Channel
+    {
+        std::vector<double> temp;
+        Column slope;
+        Column rmse;
+        Column mean;
+    };
+
+    size_t cap = 0;
+    std::vector<double> timeCol;
+    Column pwmCol;
+    std::vector<Channel> chans;
+};
+
+} // namespace autotune::experiment
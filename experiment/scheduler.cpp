@@ -0,0 +1,295 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+
+namespace autotune::experiment
+{
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr const char* journalPath =
+    "/var/lib/phosphor-pid-autotune/journal/scheduler.jnl";
+
+bool intersects(const std::vector<std::string>& a,
+                const std::vector<std::string>& b)
+{
+    return std::any_of(a.begin(), a.end(), [&b](const std::string& s) {
+        return std::find(b.begin(), b.end(), s) != b.end();
+    });
+}
+
+// a's fans disturb a sensor b records.
+bool disturbs(const Experiment& a, const Experiment& b)
+{
+    return intersects(a.coupledSensors(), b.sensors());
+}
+
+} // namespace
+
+Scheduler::Scheduler(std::vector<std::shared_ptr<Experiment>> experiments) :
+    experiments(std::move(experiments))
+{
+    const size_t n = this->experiments.size();
+    std::vector<std::vector<std::string>> fans;
+    fans.reserve(n);
+    for (const auto& e : this->experiments)
+        fans.push_back(e->fans());
+
+    conflict.assign(n, std::vector<bool>(n, false));
+    for (size_t a = 0; a < n; ++a)
+    {
+        for (size_t b = a + 1; b < n; ++b)
+        {
+            const auto& ea = *this->experiments[a];
+            const auto& eb = *this->experiments[b];
+            bool shared = intersects(fans[a], fans[b]) ||
+                          intersects(ea.sensors(), eb.sensors()) ||
+                          disturbs(ea, eb) || disturbs(eb, ea);
+            conflict[a][b] = conflict[b][a] = shared;
+        }
+    }
+}
+
+bool Scheduler::conflicts(size_t a, size_t b) const
+{
+    return conflict[a][b];
+}
+
+void Scheduler::start()
+{
+    queue.resize(experiments.size());
+    std::iota(queue.begin(), queue.end(), 0);
+    std::stable_sort(queue.begin(), queue.end(), [this](size_t a, size_t b) {
+        return experiments[a]->priority() > experiments[b]->priority();
+    });
+    runningIdx.clear();
+    finished = 0;
+    isActive = !queue.empty();
+
+    std::error_code ec;
+    fs::create_directories(fs::path(journalPath).parent_path(), ec);
+    // A launch and a finish per experiment.
+    if (isActive && journal.open(journalPath, 2 * experiments.size() + 1))
+    {
+        std::chrono::duration<double> wall =
+            std::chrono::system_clock::now().time_since_epoch();
+        journal.append({.kind = JournalKind::Begin,
+                        .time = wall.count(),
+                        .tag = batchTag()});
+    }
+
+    std::cerr << "[Scheduler] Queued " << queue.size() << " experiments\n";
+    launch();
+    notify();
+}
+
+bool Scheduler::resume()
+{
+    auto records = Journal::read(journalPath);
+    if (records.empty())
+        return false;
+    if (records.front().kind != JournalKind::Begin ||
+        records.front().tag != batchTag())
+    {
+        std::cerr << "[Scheduler] Discarding journal: batch changed\n";
+        discardJournal();
+        return false;
+    }
+
+    std::vector<bool> done(experiments.size(), false);
+    for (const auto& r : records)
+    {
+        if (r.kind == JournalKind::Done && r.channel < done.size())
+            done[r.channel] = true;
+    }
+
+    queue.clear();
+    runningIdx.clear();
+    finished = 0;
+    for (size_t i = 0; i < experiments.size(); ++i)
+    {
+        // Sampling finished before the crash; the analysis is rerunning.
+        const auto& e = *experiments[i];
+        if (!done[i] && !e.getEnabled() &&
+            e.getAnalysisStatus() != AnalysisStatus::Idle)
+            done[i] = true;
+        if (done[i])
+            ++finished;
+        else
+            queue.push_back(i);
+    }
+    std::stable_sort(queue.begin(), queue.end(), [this](size_t a, size_t b) {
+        return experiments[a]->priority() > experiments[b]->priority();
+    });
+
+    isActive = !queue.empty();
+    if (!isActive)
+    {
+        discardJournal();
+        return false;
+    }
+
+    journal.open(journalPath, records.size() + 2 * experiments.size(), true);
+    std::cerr << "[Scheduler] Resumed batch, " << finished << " of "
+              << experiments.size() << " finished\n";
+    launch();
+    notify();
+    return true;
+}
+
+void Scheduler::stop()
+{
+    queue.clear();
+    for (auto idx : runningIdx)
+        experiments[idx]->setEnabled(false);
+    runningIdx.clear();
+    isActive = false;
+    discardJournal();
+    notify();
+}
+
+void Scheduler::tick()
+{
+    if (!isActive)
+        return;
+
+    auto done = std::remove_if(
+        runningIdx.begin(), runningIdx.end(),
+        [this](size_t idx) { return !experiments[idx]->getEnabled(); });
+    bool changedSet = done != runningIdx.end();
+    for (auto it = done; it != runningIdx.end(); ++it)
+    {
+        std::cerr << "[Scheduler] " << experiments[*it]->name()
+                  << " finished\n";
+        journal.append({.kind = JournalKind::Done,
+                        .channel = static_cast<uint16_t>(*it)});
+        ++finished;
+    }
+    runningIdx.erase(done, runningIdx.end());
+
+    if (changedSet)
+    {
+        journal.sync();
+        launch();
+    }
+
+    if (queue.empty() && runningIdx.empty())
+    {
+        std::cerr << "[Scheduler] All experiments finished\n";
+        isActive = false;
+        changedSet = true;
+        discardJournal();
+    }
+
+    // Progress moves every poll; only publish whole-percent steps.
+    if (changedSet || progress() - lastProgress >= 0.01)
+        notify();
+}
+
+// Experiment names in config order; a journal from a different batch is
+// not resumed.
+uint64_t Scheduler::batchTag() const
+{
+    std::string key;
+    for (const auto& e : experiments)
+        key += e->name() + "\n";
+    return Journal::hash(key);
+}
+
+void Scheduler::discardJournal()
+{
+    journal.close();
+    std::error_code ec;
+    fs::remove(journalPath, ec);
+}
+
+void Scheduler::launch()
+{
+    // Experiments enabled individually over D-Bus hold their fans too.
+    std::vector<size_t> busy;
+    for (size_t i = 0; i < experiments.size(); ++i)
+    {
+        if (experiments[i]->getEnabled())
+            busy.push_back(i);
+    }
+
+    std::vector<size_t> waiting;
+    for (auto it = queue.begin(); it != queue.end();)
+    {
+        const size_t idx = *it;
+        if (experiments[idx]->getEnabled())
+        {
+            // Already started by hand; track it as part of the batch.
+            journal.append({.kind = JournalKind::Launch,
+                            .channel = static_cast<uint16_t>(idx)});
+            runningIdx.push_back(idx);
+            it = queue.erase(it);
+            continue;
+        }
+
+        auto clash = [this, idx](size_t other) {
+            return conflicts(idx, other);
+        };
+        // Only jump ahead of a blocked higher-priority experiment when it
+        // cannot delay that experiment once the blocker finishes.
+        bool blocked = std::any_of(busy.begin(), busy.end(), clash) ||
+                       std::any_of(waiting.begin(), waiting.end(), clash);
+        if (blocked)
+        {
+            waiting.push_back(idx);
+            ++it;
+            continue;
+        }
+
+        std::cerr << "[Scheduler] Starting " << experiments[idx]->name()
+                  << " (priority " << experiments[idx]->priority() << ")\n";
+        experiments[idx]->setEnabled(true);
+        journal.append({.kind = JournalKind::Launch,
+                        .channel = static_cast<uint16_t>(idx)});
+        busy.push_back(idx);
+        runningIdx.push_back(idx);
+        it = queue.erase(it);
+    }
+}
+
+std::vector<std::string> Scheduler::queued() const
+{
+    std::vector<std::string> names;
+    for (auto idx : queue)
+        names.push_back(experiments[idx]->name());
+    return names;
+}
+
+std::vector<std::string> Scheduler::running() const
+{
+    std::vector<std::string> names;
+    for (auto idx : runningIdx)
+        names.push_back(experiments[idx]->name());
+    return names;
+}
+
+double Scheduler::progress() const
+{
+    if (experiments.empty())
+        return 0.0;
+    double done = static_cast<double>(finished);
+    for (auto idx : runningIdx)
+        done += experiments[idx]->progress();
+    return done / static_cast<double>(experiments.size());
+}
+
+void Scheduler::notify()
+{
+    lastProgress = progress();
+    if (changed)
+        changed();
+}
+
+} // namespace autotune::experiment
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "experiment.hpp"
+#include "journal.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Runs a batch of experiments of every type, concurrently where they
+ *        cannot disturb each other.
+ *
+ * Two experiments conflict when they drive a common fan, record a common
+ * sensor, or the "coupledsensors" of one list a sensor the other records.
+ * Queued experiments start in priority order (higher first, then config
+ * order) as soon as they conflict with nothing running; a lower-priority
+ * one may start early only if it does not also conflict with a
+ * higher-priority one still waiting.
+ *
+ * The batch's position (which experiments have finished) is journaled so
+ * a restarted service can pick the batch up where it left off.
+ */
+class Scheduler
+{
+  public:
+    explicit Scheduler(std::vector<std::shared_ptr<Experiment>> experiments);
+
+    /** Queue every experiment and launch what can run now. */
+    void start();
+
+    /** Drop the queue and stop every running experiment. */
+    void stop();
+
+    /** Reap finished experiments and launch newly eligible ones. */
+    void tick();
+
+    /**
+     * @brief Continue a batch that a crash interrupted.
+     *
+     * Call after the experiments have resumed themselves. Experiments the
+     * journal marks finished, or whose analysis is already underway, are
+     * not run again; ones that resumed are adopted as running.
+     * @return true if a batch was recovered.
+     */
+    bool resume();
+
+    bool active() const
+    {
+        return isActive;
+    }
+
+    std::vector<std::string> queued() const;
+    std::vector<std::string> running() const;
+
+    /** Fraction of the batch completed, 0..1. */
+    double progress() const;
+
+    /** Called whenever the queue, running set or progress changes. */
+    void onChanged(std::function<void()> cb)
+    {
+        changed = std::move(cb);
+    }
+
+  private:
+    bool conflicts(size_t a, size_t b) const;
+    void launch();
+    void notify();
+    uint64_t batchTag() const;
+    void discardJournal();
+
+    std::vector<std::shared_ptr<Experiment>> experiments;
+    // conflict[a][b]: a and b must not run at the same time
+    std::vector<std::vector<bool>> conflict;
+
+    std::vector<size_t> queue; // indices, highest priority first
+    std::vector<size_t> runningIdx;
+    size_t finished = 0;
+    bool isActive = false;
+    double lastProgress = -1.0;
+    std::function<void()> changed;
+    Journal journal;
+};
+
+} // namespace autotune::experiment
@@ -0,0 +1,240 @@
+#include "step_analysis.hpp"
+
+#include "../core/utils.hpp"
+
+#include <fstream>
+
+namespace autotune::experiment
+{
+
+void prepareStepAnalysis(StepAnalysisInput& in, double stepIssuedTime)
+{
+    const auto& samples = *in.samples;
+    // First sample after the step; steady-state detection may have moved
+    // it ahead of initialIterations.
+    int64_t stepIdx =
+        in.triggerIdx >= 0 ? in.triggerIdx : in.exp.initialIterations;
+
+    in.stepTime = 0;
+    if (stepIssuedTime >= 0)
+    {
+        // The step starts when the first fan write went out.
+        in.stepTime = stepIssuedTime;
+    }
+    else if (stepIdx < (int64_t)samples.size())
+    {
+        in.stepTime = samples.times()[stepIdx];
+    }
+
+    in.beforeIdx =
+        (stepIdx > 0 && stepIdx < (int64_t)samples.size())
+            ? (stepIdx - 1)
+            : 0;
+
+    if (samples.empty())
+        return;
+
+    in.startMean = samples.at(in.beforeIdx, in.channel).mean;
+    in.endMean = samples.back(in.channel).mean;
+}
+
+void writeNoiseReport(const StepAnalysisInput& in)
+{
+    std::string filename = in.logDir + "/noise_" + in.sensorName + ".txt";
+    std::ofstream noiseFile(filename);
+
+    const auto& samples = *in.samples;
+    size_t win = in.basic.windowSize;
+    if (samples.empty() || samples.size() < win)
+        return;
+
+    DataPoint beforeTrig = samples.at(in.beforeIdx, in.channel);
+    DataPoint endExp = samples.back(in.channel);
+
+    noiseFile << "Name:" << in.sensorName << "\n";
+    noiseFile << "Iterations=" << samples.size() << "\n";
+    noiseFile << "Pollinterval=" << in.basic.pollInterval << "\n\n";
+
+    noiseFile << "----Before step trigger------\n";
+    noiseFile << "Slope=" << beforeTrig.slope << "\n";
+    noiseFile << "RMSE=" << beforeTrig.rmse << "\n";
+    noiseFile << "Mean=" << beforeTrig.mean << "\n\n";
+
+    noiseFile << "----After step trigger------\n";
+    noiseFile << "Slope=" << endExp.slope << "\n";
+    noiseFile << "RMSE=" << endExp.rmse << "\n";
+    noiseFile << "Mean=" << endExp.mean << "\n";
+}
+
+process_models::FOPDTParameters runTwoPoint(const StepAnalysisInput& in)
+{
+    return process_models::identifyTwoPoint(
+        in.samples->times(), in.samples->temps(in.channel),
+        in.exp.initialPwmDuty, in.exp.afterTriggerPwmDuty, in.stepTime,
+        in.startMean, in.endMean);
+}
+
+process_models::FOPDTParameters runLSM(const StepAnalysisInput& in)
+{
+    return process_models::identifyFOPDT(
+        in.samples->times(), in.samples->temps(in.channel),
+        in.exp.initialPwmDuty, in.exp.afterTriggerPwmDuty, in.stepTime,
+        in.startMean, in.endMean);
+}
+
+static process_models::FitSolver fitSolver(const config::BasicSetting& basic)
+{
+    return basic.fopdtSolver == "neldermead"
+               ? process_models::FitSolver::NelderMead
+               : process_models::FitSolver::LevenbergMarquardt;
+}
+
+process_models::FOPDTParameters runOptimization(const StepAnalysisInput& in)
+{
+    return process_models::identifyOptimization(
+        in.samples->times(), in.samples->temps(in.channel),
+        in.exp.initialPwmDuty, in.exp.afterTriggerPwmDuty, in.stepTime,
+        in.startMean, in.endMean, fitSolver(in.basic));
+}
+
+process_models::MultiStartFit
+    runMultiStart(const StepAnalysisInput& in,
+                  const process_models::FOPDTParameters& params632,
+                  const process_models::FOPDTParameters& paramsLSM,
+                  const process_models::FOPDTParameters& paramsOpt,
+                  core::ThreadPool& pool)
+{
+    if (in.basic.multiStartSeeds <= 0)
+        return {};
+    const process_models::FOPDTParameters seeds[] = {params632, paramsLSM,
+                                                     paramsOpt};
+    return process_models::identifyMultiStart(
+        in.samples->times(), in.samples->temps(in.channel),
+        in.exp.initialPwmDuty, in.exp.afterTriggerPwmDuty, in.stepTime,
+        seeds, static_cast<size_t>(in.basic.multiStartSeeds), &pool,
+        in.startMean, in.endMean, fitSolver(in.basic));
+}
+
+void writeFOPDTReport(const StepAnalysisInput& in,
+                      const process_models::FOPDTParameters& params632,
+                      const process_models::FOPDTParameters& paramsLSM,
+                      const process_models::FOPDTParameters& paramsOpt,
+                      const process_models::MultiStartFit& multiStart)
+{
+    std::string filename = in.logDir + "/fopdt_" + in.sensorName + ".txt";
+    std::ofstream fFile(filename);
+    fFile << "Name:" << in.sensorName << "\n";
+    fFile << "StepTime=" << in.stepTime << "\n";
+    fFile << "StepAcked=" << in.stepAckedTime << "\n\n";
+
+    fFile << "------632 Method--------\n";
+    fFile << "k=" << params632.k << "\n";
+    fFile << "tau=" << params632.tau << "\n";
+    fFile << "theta=" << params632.theta << "\n\n";
+
+    fFile << "------LSM Method--------\n";
+    fFile << "k=" << paramsLSM.k << "\n";
+    fFile << "tau=" << paramsLSM.tau << "\n";
+    fFile << "theta=" << paramsLSM.theta << "\n\n";
+
+    fFile << "------Optimization Method--------\n";
+    fFile << "k=" << paramsOpt.k << "\n";
+    fFile << "tau=" << paramsOpt.tau << "\n";
+    fFile << "theta=" << paramsOpt.theta << "\n";
+
+    if (in.online.valid)
+    {
+        fFile << "\n------Online Estimate--------\n";
+        fFile << "k=" << in.online.params.k << "\n";
+        fFile << "tau=" << in.online.params.tau << "\n";
+        fFile << "theta=" << in.online.params.theta << "\n";
+        fFile << "k_std=" << in.online.kStd << "\n";
+        fFile << "tau_std=" << in.online.tauStd << "\n";
+        fFile << "theta_std=" << in.online.thetaStd << "\n";
+    }
+
+    if (multiStart.valid)
+    {
+        fFile << "\n------MultiStart Method--------\n";
+        fFile << "k=" << multiStart.best.k << "\n";
+        fFile << "tau=" << multiStart.best.tau << "\n";
+        fFile << "theta=" << multiStart.best.theta << "\n";
+        fFile << "rmse=" << multiStart.rmse << "\n";
+        fFile << "screened=" << multiStart.screened << "\n";
+        fFile << "starts=" << multiStart.starts << "\n";
+        fFile << "agreeing=" << multiStart.agreeing << "\n";
+        fFile << "k_spread=" << multiStart.spread.k << "\n";
+        fFile << "tau_spread=" << multiStart.spread.tau << "\n";
+        fFile << "theta_spread=" << multiStart.spread.theta << "\n";
+    }
+}
+
+std::vector<process_models::ModelFit>
+    runModelSelection(const StepAnalysisInput& in,
+                      const process_models::FOPDTParameters& paramsOpt,
+                      const process_models::MultiStartFit& multiStart,
+                      core::ThreadPool& pool)
+{
+    if (!in.basic.modelSelection)
+        return {};
+    double dutyChange =
+        core::scaleRawToDuty(static_cast<int>(in.exp.afterTriggerPwmDuty)) -
+        core::scaleRawToDuty(static_cast<int>(in.exp.initialPwmDuty));
+    static const auto models = process_models::makeStepModels();
+    // Epsilon = theta, the same default tool/app/pid_algo.py starts from.
+    return process_models::fitStepModels(
+        in.samples->times(), in.samples->temps(in.channel), in.stepTime,
+        in.startMean, dutyChange,
+        multiStart.valid ? multiStart.best : paramsOpt, models, &pool, 1.0);
+}
+
+static void writeModelFit(std::ofstream& f,
+                          const process_models::ModelFit& fit)
+{
+    f << "model=" << fit.model << "\n";
+    for (size_t i = 0; i < fit.params.size(); ++i)
+        f << fit.names[i] << "=" << fit.params[i] << "\n";
+    f << "rmse=" << fit.rmse << "\n";
+    f << "aic=" << fit.aic << "\n";
+    f << "bic=" << fit.bic << "\n";
+    f << "kp=" << fit.pid.kp << "\n";
+    f << "ki=" << fit.pid.ki << "\n";
+    f << "kd=" << fit.pid.kd << "\n";
+}
+
+void writeModelReport(const StepAnalysisInput& in,
+                      const std::vector<process_models::ModelFit>& fits)
+{
+    if (fits.empty())
+        return;
+    std::string filename = in.logDir + "/model_" + in.sensorName + ".txt";
+    std::ofstream fFile(filename);
+    fFile << "Name:" << in.sensorName << "\n";
+    fFile << "StepTime=" << in.stepTime << "\n\n";
+
+    if (!fits.front().valid)
+    {
+        fFile << "selected=none\n";
+        return;
+    }
+
+    // fits is sorted by BIC with failed fits last.
+    fFile << "------Selected Model--------\n";
+    writeModelFit(fFile, fits.front());
+    if (fits.size() > 1 && fits[1].valid)
+    {
+        fFile << "runner_up=" << fits[1].model << "\n";
+        fFile << "delta_bic=" << fits[1].bic - fits.front().bic << "\n";
+    }
+
+    for (size_t i = 1; i < fits.size(); ++i)
+    {
+        fFile << "\n------Candidate " << fits[i].model << "--------\n";
+        if (fits[i].valid)
+            writeModelFit(fFile, fits[i]);
+        else
+            fFile << "valid=0\n";
+    }
+}
+
+} // namespace autotune::experiment
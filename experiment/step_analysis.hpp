@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "../core/thread_pool.hpp"
+#include "../process_models/fopdt.hpp"
+#include "../process_models/online_fopdt.hpp"
+#include "../process_models/step_model.hpp"
+#include "sample_store.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Everything the post-experiment analysis needs, detached from the
+ *        StepTrigger so it can run on a worker thread while the experiment
+ *        object is reused.
+ */
+struct StepAnalysisInput
+{
+    std::string sensorName;
+    std::string logDir;
+    config::BasicSetting basic;
+    config::ExperimentConfig exp;
+    std::shared_ptr<const SampleStore> samples;
+    size_t channel = 0; // column of sensorName in samples
+
+    double stepTime = 0.0;
+    double stepAckedTime = -1.0;
+    int64_t triggerIdx = -1; // first sample after the step, -1 if none
+    size_t beforeIdx = 0; // last sample before the step
+    double startMean = 0.0;
+    double endMean = 0.0;
+    // Final recursive estimate; valid only when onlinefopdt is enabled.
+    process_models::OnlineFOPDTEstimate online;
+};
+
+/** Fill the step/mean fields of @p in from its samples. */
+void prepareStepAnalysis(StepAnalysisInput& in, double stepIssuedTime);
+
+/** Write noise_<sensor>.txt. */
+void writeNoiseReport(const StepAnalysisInput& in);
+
+process_models::FOPDTParameters runTwoPoint(const StepAnalysisInput& in);
+process_models::FOPDTParameters runLSM(const StepAnalysisInput& in);
+process_models::FOPDTParameters runOptimization(const StepAnalysisInput& in);
+
+/**
+ * @brief Multi-start global fit seeded with the three estimates, when
+ *        "multistartseeds" is set; invalid otherwise. Fans out on @p pool
+ *        and is safe to call from one of its jobs.
+ */
+process_models::MultiStartFit
+    runMultiStart(const StepAnalysisInput& in,
+                  const process_models::FOPDTParameters& params632,
+                  const process_models::FOPDTParameters& paramsLSM,
+                  const process_models::FOPDTParameters& paramsOpt,
+                  core::ThreadPool& pool);
+
+/** Write fopdt_<sensor>.txt. */
+void writeFOPDTReport(const StepAnalysisInput& in,
+                      const process_models::FOPDTParameters& params632,
+                      const process_models::FOPDTParameters& paramsLSM,
+                      const process_models::FOPDTParameters& paramsOpt,
+                      const process_models::MultiStartFit& multiStart);
+
+/**
+ * @brief Fit the candidate model family to the step, starting from the
+ *        multi-start best when valid and @p paramsOpt otherwise; empty when
+ *        "modelselection" is off. Safe to call from a job on @p pool.
+ */
+std::vector<process_models::ModelFit>
+    runModelSelection(const StepAnalysisInput& in,
+                      const process_models::FOPDTParameters& paramsOpt,
+                      const process_models::MultiStartFit& multiStart,
+                      core::ThreadPool& pool);
+
+/** Write model_<sensor>.txt; nothing when @p fits is empty. */
+void writeModelReport(const StepAnalysisInput& in,
+                      const std::vector<process_models::ModelFit>& fits);
+
+} // namespace autotune::experiment
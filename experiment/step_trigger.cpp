@@ -1,24 +1,50 @@
 #include "step_trigger.hpp"
 
-#include "../core/dbus_io.hpp"
+#include "../core/backend.hpp"
 #include "../core/utils.hpp"
 #include "../process_models/fopdt.hpp"
+#include "step_analysis.hpp"
 
+#include <boost/asio/post.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <filesystem>
 #include <iostream>
+#include <sstream>
 
 namespace autotune::experiment
 {
 
 namespace fs = std::filesystem;
 
-StepTrigger::StepTrigger(sdbusplus::bus_t& b,
+StepTrigger::StepTrigger(boost::asio::io_context& io,
+                         core::ThreadPool& analysisPool,
                          const std::string& objectPath, // Match definition
                          const config::BasicSetting& basic,
                          const config::ExperimentConfig& exp) :
-    bus(b), objectPath(objectPath), basicCfg(basic), expCfg(exp)
-{}
+    io(io), analysisPool(analysisPool), objectPath(objectPath),
+    basicCfg(basic), expCfg(exp),
+    stats(exp.observedSensors.size(),
+          core::RollingStats(
+              static_cast<size_t>(std::max(basic.windowSize, 1))))
+{
+    for (size_t i = 0; i < expCfg.observedSensors.size(); ++i)
+        logWriters.push_back(makeLogWriter(basicCfg));
+}
+
+std::vector<std::string> StepTrigger::fans() const
+{
+    std::vector<std::string> all = expCfg.initialFanSensors;
+    for (const auto& f : expCfg.afterTriggerFanSensors)
+    {
+        if (std::find(all.begin(), all.end(), f) == all.end())
+            all.push_back(f);
+    }
+    return all;
+}
 
 void StepTrigger::setEnabled(bool enable)
 {
@@ -31,6 +57,29 @@ void StepTrigger::setEnabled(bool enable)
         stop();
 }
 
+void StepTrigger::resetRun()
+{
+    currentIteration = 0;
+    triggerIndex = -1;
+    phaseStartTime = 0.0;
+    steadySince = -1.0;
+    preStepMean = 0.0;
+    preStepNoise = 0.0;
+    responded = false;
+    readInFlight = false;
+    runId++;
+    stepIssuedTime = -1.0;
+    stepAckedTime = -1.0;
+    convergedSince = -1.0;
+    for (auto& s : stats)
+        s.reset();
+    size_t budget = static_cast<size_t>(std::max(
+        expCfg.initialIterations + expCfg.afterTriggerIterations, 0));
+    samples.reset(budget, expCfg.observedSensors.size(),
+                  basicCfg.compactStorage);
+    logDir = "/var/lib/phosphor-pid-autotune/log/" + expCfg.tempSensor;
+}
+
 void StepTrigger::start()
 {
     if (running)
@@ -38,13 +87,10 @@ void StepTrigger::start()
 
     running = true;
     state = State::InitialWait;
-    currentIteration = 0;
-    history.clear();
-    fullLog.clear();
+    resetRun();
     startTime = std::chrono::steady_clock::now();
     lastTickTime = std::chrono::steady_clock::now();
 
-    logDir = "/var/lib/phosphor-pid-autotune/log/" + expCfg.tempSensor;
     std::cerr << "[StepTrigger] Starting " << expCfg.tempSensor
               << " LogDir: " << logDir << "\n";
     try
@@ -54,34 +100,252 @@ void StepTrigger::start()
             std::cerr << "[StepTrigger] Created log directory: " << logDir
                       << "\n";
         }
+        fs::create_directories(fs::path(journalPath()).parent_path());
     }
     catch (const fs::filesystem_error& e)
     {
         std::cerr << "Error creating log dir: " << e.what() << "\n";
     }
 
-    std::string filename =
-        logDir + "/step_trigger_" + expCfg.tempSensor + ".txt";
-    logFile.open(filename, std::ios::out | std::ios::trunc);
-    logFile << "n,time,temp,pwm,slope,rmse,mean_temp\n";
+    // One log per observed sensor, all in the experiment's directory.
+    for (size_t i = 0; i < logWriters.size(); ++i)
+    {
+        const auto& sensor = expCfg.observedSensors[i];
+        openLog(*logWriters[i], logDir + "/step_trigger_" + sensor,
+                logMetadata(sensor), basicCfg);
+    }
+
+    // Room for every sample of every channel plus the phase records.
+    size_t records = static_cast<size_t>(std::max(
+                         expCfg.initialIterations +
+                             expCfg.afterTriggerIterations,
+                         0)) *
+                         expCfg.observedSensors.size() +
+                     16;
+    if (journal.open(journalPath(), records))
+    {
+        std::chrono::duration<double> wall =
+            std::chrono::system_clock::now().time_since_epoch();
+        journal.append({.kind = JournalKind::Begin,
+                        .time = wall.count(),
+                        .tag = configTag()});
+        journalPhase(0.0);
+    }
 
-    dbusio::writePwmAllByInput(expCfg.initialFanSensors, expCfg.initialPwmDuty);
+    writePwm(expCfg.initialFanSensors, expCfg.initialPwmDuty);
 
     std::cerr << "[StepTrigger] Started " << expCfg.tempSensor
               << " Initial PWM: " << expCfg.initialPwmDuty << "\n";
 }
 
+std::string StepTrigger::journalPath() const
+{
+    return "/var/lib/phosphor-pid-autotune/journal/" + expCfg.tempSensor +
+           ".jnl";
+}
+
+// A journal only resumes under the configuration that wrote it.
+uint64_t StepTrigger::configTag() const
+{
+    std::string key = logMetadata(expCfg.tempSensor);
+    for (const auto& sensor : expCfg.observedSensors)
+        key += "," + sensor;
+    return Journal::hash(key);
+}
+
+void StepTrigger::journalPhase(double time, double value, double aux)
+{
+    journal.append({.kind = JournalKind::Phase,
+                    .iteration = currentIteration,
+                    .time = time,
+                    .value = value,
+                    .aux = aux,
+                    .tag = static_cast<uint64_t>(state)});
+    journal.sync();
+}
+
+void StepTrigger::discardJournal()
+{
+    journal.close();
+    std::error_code ec;
+    fs::remove(journalPath(), ec);
+}
+
+bool StepTrigger::resume()
+{
+    auto records = Journal::read(journalPath());
+    if (records.empty())
+        return false;
+
+    const auto& begin = records.front();
+    if (begin.kind != JournalKind::Begin || begin.tag != configTag())
+    {
+        std::cerr << "[StepTrigger] Discarding journal of "
+                  << expCfg.tempSensor << ": configuration changed\n";
+        discardJournal();
+        return false;
+    }
+
+    state = State::InitialWait;
+    resetRun();
+
+    double dutyChange =
+        core::scaleRawToDuty(static_cast<int>(expCfg.afterTriggerPwmDuty)) -
+        core::scaleRawToDuty(static_cast<int>(expCfg.initialPwmDuty));
+
+    // Samples are journaled one record per channel; a sample is replayed
+    // once all of its channels are in, so a torn one is dropped.
+    size_t channels = expCfg.observedSensors.size();
+    channelValues.assign(channels, ChannelSample{});
+    int64_t pendingIter = -1;
+    size_t pendingCount = 0;
+    double pendingTime = 0.0;
+    double pendingPwm = 0.0;
+    auto replay = [&] {
+        if (pendingIter < 0 || pendingCount < channels)
+            return;
+        for (size_t i = 0; i < channels; ++i)
+        {
+            auto& st = stats[i];
+            auto& cv = channelValues[i];
+            st.push(pendingTime, cv.temp);
+            cv.slope = st.slope();
+            cv.rmse = st.rmse();
+            cv.mean = st.mean();
+        }
+        samples.append(pendingTime, pendingPwm, channelValues);
+        if (state == State::AfterTriggerWait && basicCfg.onlineFopdt)
+            online.update(pendingTime, channelValues.front().temp);
+        currentIteration = pendingIter + 1;
+        pendingIter = -1;
+        pendingCount = 0;
+    };
+
+    for (size_t k = 1; k < records.size(); ++k)
+    {
+        const auto& r = records[k];
+        switch (r.kind)
+        {
+            case JournalKind::Sample:
+                if (r.iteration != pendingIter)
+                {
+                    replay();
+                    pendingIter = r.iteration;
+                    pendingCount = 0;
+                }
+                if (r.channel < channels)
+                {
+                    channelValues[r.channel].temp = r.value;
+                    pendingCount++;
+                }
+                pendingTime = r.time;
+                pendingPwm = r.aux;
+                break;
+            case JournalKind::Phase:
+                replay();
+                state = static_cast<State>(r.tag);
+                if (state == State::AfterTriggerWait)
+                {
+                    triggerIndex = r.iteration;
+                    phaseStartTime = r.time;
+                    // The stats hold the pre-step window at this point.
+                    preStepMean = r.value;
+                    preStepNoise = stats.front().rmse();
+                    if (basicCfg.onlineFopdt)
+                        online.reset(r.aux, r.value, dutyChange,
+                                     basicCfg.onlineMaxDeadTime,
+                                     basicCfg.pollInterval);
+                }
+                break;
+            case JournalKind::Step:
+                stepIssuedTime = r.time;
+                stepAckedTime = r.value;
+                break;
+            default:
+                break;
+        }
+    }
+    replay();
+
+    // Keep the original time axis: the outage shows up as a gap.
+    std::chrono::duration<double> wall =
+        std::chrono::system_clock::now().time_since_epoch();
+    startTime = std::chrono::steady_clock::now() -
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(wall.count() - begin.time));
+    lastTickTime = std::chrono::steady_clock::now();
+
+    std::cerr << "[StepTrigger] Recovered " << expCfg.tempSensor << " at "
+              << currentIteration << " samples\n";
+
+    if (state == State::Finished)
+    {
+        // Sampling was complete; only the analysis was lost.
+        journal.close();
+        submitAnalysis();
+        return true;
+    }
+    if (state != State::AfterTriggerWait)
+        state = State::InitialWait;
+
+    running = true;
+    enabled = true;
+    journal.open(journalPath(), records.size(), true);
+    for (size_t i = 0; i < logWriters.size(); ++i)
+    {
+        const auto& sensor = expCfg.observedSensors[i];
+        openLog(*logWriters[i], logDir + "/step_trigger_" + sensor,
+                logMetadata(sensor), basicCfg, true);
+    }
+    std::chrono::duration<double> now =
+        std::chrono::steady_clock::now() - startTime;
+    std::ostringstream line;
+    line << "#resumed=" << now.count() << ",samples=" << currentIteration;
+    logNote(line.str());
+
+    writePwm(expCfg.initialFanSensors, expCfg.initialPwmDuty);
+    if (state == State::AfterTriggerWait)
+        writePwm(expCfg.afterTriggerFanSensors, expCfg.afterTriggerPwmDuty);
+    return true;
+}
+
+std::string StepTrigger::logMetadata(const std::string& sensor) const
+{
+    nlohmann::json j;
+    j["tempsensor"] = sensor;
+    if (sensor != expCfg.tempSensor)
+        j["stepsensor"] = expCfg.tempSensor;
+    j["pollinterval"] = basicCfg.pollInterval;
+    j["windowsize"] = basicCfg.windowSize;
+    j["initialfansensors"] = expCfg.initialFanSensors;
+    j["initialpwmduty"] = expCfg.initialPwmDuty;
+    j["aftertriggerfansensors"] = expCfg.afterTriggerFanSensors;
+    j["aftertriggerpwmduty"] = expCfg.afterTriggerPwmDuty;
+    j["initialiterations"] = expCfg.initialIterations;
+    j["aftertriggeriterations"] = expCfg.afterTriggerIterations;
+    if (basicCfg.steadyState)
+    {
+        j["steadyslope"] = basicCfg.steadySlope;
+        j["steadyrmse"] = basicCfg.steadyRmse;
+        j["steadyhold"] = basicCfg.steadyHold;
+    }
+    return j.dump();
+}
+
 void StepTrigger::stop()
 {
     running = false;
     state = State::Idle;
-    if (logFile.is_open())
-        logFile.close();
+    io::backend().releasePwm(fans());
+    for (auto& w : logWriters)
+        w->close();
+    // Stopped on purpose; nothing to resume.
+    discardJournal();
 }
 
 void StepTrigger::tick()
 {
-    if (!running)
+    if (!running || readInFlight)
         return;
 
     auto now = std::chrono::steady_clock::now();
@@ -94,39 +358,183 @@ void StepTrigger::tick()
     iteration();
 }
 
+void StepTrigger::writePwm(const std::vector<std::string>& fans, double duty,
+                           io::WriteHandler onDone)
+{
+    std::string sensor = expCfg.tempSensor;
+    io::backend().writePwm(
+        fans, static_cast<int>(duty),
+        [sensor, onDone](const io::WriteResult& result) {
+            if (!result.ok)
+                std::cerr << "[StepTrigger] PWM write failed for " << sensor
+                          << "\n";
+            if (onDone)
+                onDone(result);
+        });
+}
+
+void StepTrigger::recordStepWindow(const io::WriteResult& result)
+{
+    std::chrono::duration<double> issued = result.issued - startTime;
+    std::chrono::duration<double> acked = result.acked - startTime;
+    stepIssuedTime = issued.count();
+    stepAckedTime = acked.count();
+    journal.append({.kind = JournalKind::Step,
+                    .time = stepIssuedTime,
+                    .value = stepAckedTime});
+
+    std::cerr << "[StepTrigger] Step window for " << expCfg.tempSensor << ": "
+              << stepIssuedTime << "s - " << stepAckedTime << "s\n";
+
+    std::ostringstream line;
+    line << "#step_issued=" << stepIssuedTime
+         << ",step_acked=" << stepAckedTime;
+    logNote(line.str());
+}
+
+// A phase is steady once the rolling window holds only samples from this
+// phase and its slope and RMSE have stayed under the thresholds for the
+// hold time. After the step the process must first have responded, or the
+// flat dead-time plateau would pass as steady.
+bool StepTrigger::phaseSettled(double time)
+{
+    if (!basicCfg.steadyState)
+        return false;
+
+    bool afterStep = state == State::AfterTriggerWait;
+    int64_t phaseStart = afterStep ? triggerIndex : 0;
+    const auto& primary = stats.front();
+    if (!primary.full() ||
+        currentIteration - phaseStart < basicCfg.windowSize)
+    {
+        return false;
+    }
+
+    if (afterStep && !responded)
+    {
+        double band = 3.0 * std::max(preStepNoise, basicCfg.steadyRmse);
+        responded = std::abs(primary.mean() - preStepMean) > band ||
+                    time - phaseStartTime >= basicCfg.onlineMaxDeadTime;
+        if (!responded)
+            return false;
+    }
+
+    if (std::abs(primary.slope()) > basicCfg.steadySlope ||
+        primary.rmse() > basicCfg.steadyRmse)
+    {
+        steadySince = -1.0;
+        return false;
+    }
+
+    if (steadySince < 0)
+        steadySince = time;
+    return time - steadySince >= basicCfg.steadyHold;
+}
+
+// Feed the sample to the online estimator and report whether it has stayed
+// within tolerance long enough to end the phase.
+bool StepTrigger::onlineConverged(double time, double temp)
+{
+    if (!basicCfg.onlineFopdt)
+        return false;
+
+    online.update(time, temp);
+    if (onlineEstimateChanged)
+        onlineEstimateChanged();
+
+    if (!online.estimate().converged(basicCfg.onlineTolerance,
+                                     online.resolution()))
+    {
+        convergedSince = -1.0;
+        return false;
+    }
+    if (convergedSince < 0)
+        convergedSince = time;
+    return basicCfg.onlineStop && time - convergedSince >= basicCfg.onlineHold;
+}
+
+void StepTrigger::endPhase(const char* phase, const char* reason, double time)
+{
+    int64_t phaseStart = (state == State::AfterTriggerWait) ? triggerIndex
+                                                            : 0;
+    int64_t count = currentIteration - phaseStart;
+    double duration = time - phaseStartTime;
+
+    std::cerr << "[StepTrigger] " << expCfg.tempSensor << " " << phase
+              << " phase ended (" << reason << ") after " << count
+              << " samples, " << duration << "s\n";
+
+    std::ostringstream line;
+    line << "#phase=" << phase << ",samples=" << count
+         << ",duration=" << duration << ",reason=" << reason;
+    logNote(line.str());
+}
+
 void StepTrigger::iteration()
 {
-    double temp = dbusio::readTempCByInput(expCfg.tempSensor);
+    readInFlight = true;
+    std::weak_ptr<StepTrigger> weak = weak_from_this();
+    uint64_t id = runId;
+
+    io::backend().readTempsC(
+        expCfg.observedSensors,
+        [weak, id](std::vector<std::optional<double>> temps,
+                   std::chrono::steady_clock::time_point completed) {
+            auto self = weak.lock();
+            if (!self || self->runId != id)
+                return;
+            self->readInFlight = false;
+            if (!self->running)
+                return;
+            self->recordSample(temps, completed);
+        });
+}
+
+void StepTrigger::recordSample(
+    const std::vector<std::optional<double>>& temps,
+    std::chrono::steady_clock::time_point completed)
+{
     double currentPwm = (state == State::InitialWait)
                             ? expCfg.initialPwmDuty
                             : expCfg.afterTriggerPwmDuty;
 
-    std::chrono::duration<double> t_diff =
-        std::chrono::steady_clock::now() - startTime;
+    // Stamp the sample with the time the reading arrived, not when the
+    // poll was issued.
+    std::chrono::duration<double> t_diff = completed - startTime;
     double timestamp = t_diff.count();
 
-    DataPoint dp{currentIteration, timestamp, temp, currentPwm, 0, 0, 0};
-    history.push_back(dp);
-
-    size_t win = static_cast<size_t>(basicCfg.windowSize);
-    std::vector<double> histTemp, histTime;
-    size_t startIdx = (history.size() > win) ? (history.size() - win) : 0;
-
-    for (size_t i = startIdx; i < history.size(); ++i)
+    channelValues.resize(temps.size());
+    for (size_t i = 0; i < temps.size(); ++i)
     {
-        histTemp.push_back(history[i].temp);
-        histTime.push_back(history[i].time);
+        auto& st = stats[i];
+        auto& cv = channelValues[i];
+        cv.temp = temps[i].value_or(0.0);
+        st.push(timestamp, cv.temp);
+        cv.slope = st.slope();
+        cv.rmse = st.rmse();
+        cv.mean = st.mean();
+        logWriters[i]->sample(DataPoint{currentIteration, timestamp, cv.temp,
+                                        currentPwm, cv.slope, cv.rmse,
+                                        cv.mean});
+        journal.append({.kind = JournalKind::Sample,
+                        .channel = static_cast<uint16_t>(i),
+                        .iteration = currentIteration,
+                        .time = timestamp,
+                        .value = cv.temp,
+                        .aux = currentPwm});
     }
 
-    dp.slope = core::calculateSlope(histTemp, histTime, win);
-    dp.rmse = core::calculateRMSE(histTemp, win);
-    dp.mean = core::calculateMean(histTemp, win);
-
-    fullLog.push_back(dp);
+    if (!samples.append(timestamp, currentPwm, channelValues))
+    {
+        std::cerr << "[StepTrigger] Sample store full for "
+                  << expCfg.tempSensor << ", sample " << currentIteration
+                  << " not kept\n";
+    }
 
-    logFile << dp.n << "," << dp.time << "," << dp.temp << "," << dp.pwm << ","
-            << dp.slope << "," << dp.rmse << "," << dp.mean << "\n";
-    logFile.flush();
+    // The primary (step) sensor drives the phase logic.
+    const auto& cv = channelValues.front();
+    DataPoint dp{currentIteration, timestamp, cv.temp, currentPwm,
+                 cv.slope, cv.rmse, cv.mean};
 
     // Continuous Plot Logging
     int rate = basicCfg.plotSamplingRate;
@@ -139,14 +547,27 @@ void StepTrigger::iteration()
 
     if (state == State::InitialWait)
     {
-        if (currentIteration >= expCfg.initialIterations)
+        bool limit = currentIteration >= expCfg.initialIterations;
+        if (limit || phaseSettled(dp.time))
+        {
+            endPhase("initial", limit ? "limit" : "steady", dp.time);
             state = State::trigger;
+            for (auto& w : logWriters)
+                w->sync();
+        }
     }
     else if (state == State::AfterTriggerWait)
     {
-        if (currentIteration >=
-            (expCfg.initialIterations + expCfg.afterTriggerIterations))
+        bool limit = currentIteration - triggerIndex >=
+                     expCfg.afterTriggerIterations;
+        const char* reason = limit ? "limit" : nullptr;
+        if (!reason && onlineConverged(dp.time, dp.temp))
+            reason = "converged";
+        if (!reason && phaseSettled(dp.time))
+            reason = "steady";
+        if (reason)
         {
+            endPhase("aftertrigger", reason, dp.time);
             state = State::Finished;
             finishExperiment();
         }
@@ -156,122 +577,171 @@ void StepTrigger::iteration()
     {
         std::cout << "[StepTrigger] Triggering step for " << expCfg.tempSensor
                   << "\n";
-        dbusio::writePwmAllByInput(expCfg.afterTriggerFanSensors,
-                                   expCfg.afterTriggerPwmDuty);
+        std::weak_ptr<StepTrigger> weak = weak_from_this();
+        uint64_t id = runId;
+        writePwm(expCfg.afterTriggerFanSensors, expCfg.afterTriggerPwmDuty,
+                 [weak, id](const io::WriteResult& result) {
+                     auto self = weak.lock();
+                     if (self && self->runId == id)
+                         self->recordStepWindow(result);
+                 });
+        triggerIndex = currentIteration;
+        phaseStartTime = dp.time;
+        steadySince = -1.0;
+        std::chrono::duration<double> issued =
+            std::chrono::steady_clock::now() - startTime;
+        const auto& primary = stats.front();
+        double baseline = primary.full() ? primary.mean() : dp.temp;
+        preStepMean = baseline;
+        preStepNoise = primary.full() ? primary.rmse() : 0.0;
+        responded = false;
+        if (basicCfg.onlineFopdt)
+        {
+            online.reset(issued.count(), baseline,
+                         core::scaleRawToDuty(
+                             static_cast<int>(expCfg.afterTriggerPwmDuty)) -
+                             core::scaleRawToDuty(
+                                 static_cast<int>(expCfg.initialPwmDuty)),
+                         basicCfg.onlineMaxDeadTime, basicCfg.pollInterval);
+            convergedSince = -1.0;
+        }
         state = State::AfterTriggerWait;
+        // Everything resume() needs to rebuild the online estimator.
+        journal.append({.kind = JournalKind::Phase,
+                        .iteration = triggerIndex,
+                        .time = phaseStartTime,
+                        .value = baseline,
+                        .aux = issued.count(),
+                        .tag = static_cast<uint64_t>(state)});
+        journal.sync();
     }
 }
 
 void StepTrigger::finishExperiment()
 {
     std::cout << "[StepTrigger] Finished " << expCfg.tempSensor << "\n";
-    logFile.close();
-    runAnalysis();
+    // Sampling is complete; a crash from here on only reruns the analysis.
+    journalPhase(phaseStartTime);
+    journal.close();
+    submitAnalysis();
     enabled = false;
     running = false;
+    io::backend().releasePwm(fans());
 }
 
-void StepTrigger::runAnalysis()
+// Hand the samples and the log writers to the worker pool and return
+// immediately: for every observed sensor the noise report and the three
+// FOPDT identifiers run as separate jobs, and whichever finishes last writes
+// that sensor's FOPDT report. Done is posted back to the io_context once
+// every sensor is reported.
+void StepTrigger::submitAnalysis()
 {
-    runNoiseAnalysis(expCfg.tempSensor);
-    runFOPDTAnalysis(expCfg.tempSensor);
-}
+    auto store = std::make_shared<const SampleStore>(std::move(samples));
 
-StepTrigger::AnalysisData StepTrigger::prepareAnalysisData()
-{
-    AnalysisData data;
-    for (const auto& dp : fullLog)
+    struct Job
     {
-        data.times.push_back(dp.time);
-        data.temps.push_back(dp.temp);
-    }
-
-    data.stepTime = 0;
-    if (expCfg.initialIterations < (int)fullLog.size())
+        std::shared_ptr<const StepAnalysisInput> input;
+        std::shared_ptr<LogWriter> writer;
+        process_models::FOPDTParameters params632;
+        process_models::FOPDTParameters paramsLSM;
+        process_models::FOPDTParameters paramsOpt;
+        std::atomic<int> remaining{4};
+    };
+
+    struct Batch
+    {
+        std::atomic<bool> started{false};
+        std::atomic<size_t> remaining{0};
+    };
+
+    uint64_t id = beginAnalysis();
+
+    std::weak_ptr<StepTrigger> weak = weak_from_this();
+    auto post = [&ioc = io, weak, id](AnalysisStatus status) {
+        boost::asio::post(ioc, [weak, id, status] {
+            auto self = weak.lock();
+            if (!self)
+                return;
+            self->setAnalysisStatus(id, status);
+            // The reports are on disk; the journal has served its purpose
+            // unless a new run has already taken it over.
+            if (status == AnalysisStatus::Done && !self->running)
+                self->discardJournal();
+        });
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = expCfg.observedSensors.size();
+
+    for (size_t ch = 0; ch < expCfg.observedSensors.size(); ++ch)
     {
-        data.stepTime = fullLog[expCfg.initialIterations].time;
+        auto input = std::make_shared<StepAnalysisInput>();
+        input->sensorName = expCfg.observedSensors[ch];
+        input->logDir = logDir;
+        input->basic = basicCfg;
+        input->exp = expCfg;
+        input->samples = store;
+        input->channel = ch;
+        input->stepAckedTime = stepAckedTime;
+        input->triggerIdx = triggerIndex;
+        if (basicCfg.onlineFopdt && ch == 0)
+            input->online = online.estimate();
+        prepareStepAnalysis(*input, stepIssuedTime);
+
+        auto job = std::make_shared<Job>();
+        job->input = input;
+        // The writer drains and fsyncs on a worker; start() gets a fresh
+        // one.
+        job->writer = std::move(logWriters[ch]);
+        logWriters[ch] = makeLogWriter(basicCfg);
+
+        auto begin = [batch, post] {
+            if (!batch->started.exchange(true))
+                post(AnalysisStatus::Running);
+        };
+        auto end = [job, batch, post, &pool = analysisPool] {
+            if (--job->remaining > 0)
+                return;
+            auto multiStart = runMultiStart(*job->input, job->params632,
+                                            job->paramsLSM, job->paramsOpt,
+                                            pool);
+            writeFOPDTReport(*job->input, job->params632, job->paramsLSM,
+                             job->paramsOpt, multiStart);
+            writeModelReport(*job->input,
+                             runModelSelection(*job->input, job->paramsOpt,
+                                               multiStart, pool));
+            if (--batch->remaining == 0)
+                post(AnalysisStatus::Done);
+        };
+
+        analysisPool.submit([job, begin, end] {
+            begin();
+            job->writer->close();
+            writeNoiseReport(*job->input);
+            end();
+        });
+        analysisPool.submit([job, begin, end] {
+            begin();
+            job->params632 = runTwoPoint(*job->input);
+            end();
+        });
+        analysisPool.submit([job, begin, end] {
+            begin();
+            job->paramsLSM = runLSM(*job->input);
+            end();
+        });
+        analysisPool.submit([job, begin, end] {
+            begin();
+            job->paramsOpt = runOptimization(*job->input);
+            end();
+        });
     }
-
-    size_t beforeIdx = (expCfg.initialIterations > 0 &&
-                        expCfg.initialIterations < (int)fullLog.size())
-                           ? (expCfg.initialIterations - 1)
-                           : 0;
-
-    data.startMean = fullLog[beforeIdx].mean;
-    data.endMean = fullLog.back().mean;
-
-    return data;
-}
-
-void StepTrigger::runNoiseAnalysis(const std::string& sensorName)
-{
-    std::string filename = logDir + "/noise_" + sensorName + ".txt";
-    std::ofstream noiseFile(filename);
-
-    size_t win = basicCfg.windowSize;
-    if (fullLog.size() < win)
-        return;
-
-    size_t beforeIdx = (expCfg.initialIterations > 0 &&
-                        expCfg.initialIterations < (int)fullLog.size())
-                           ? (expCfg.initialIterations - 1)
-                           : 0;
-
-    DataPoint beforeTrig = fullLog[beforeIdx];
-    DataPoint endExp = fullLog.back();
-
-    noiseFile << "Name:" << sensorName << "\n";
-    noiseFile << "Iterations=" << fullLog.size() << "\n";
-    noiseFile << "Pollinterval=" << basicCfg.pollInterval << "\n\n";
-
-    noiseFile << "----Before step trigger------\n";
-    noiseFile << "Slope=" << beforeTrig.slope << "\n";
-    noiseFile << "RMSE=" << beforeTrig.rmse << "\n";
-    noiseFile << "Mean=" << beforeTrig.mean << "\n\n";
-
-    noiseFile << "----After step trigger------\n";
-    noiseFile << "Slope=" << endExp.slope << "\n";
-    noiseFile << "RMSE=" << endExp.rmse << "\n";
-    noiseFile << "Mean=" << endExp.mean << "\n";
 }
 
-void StepTrigger::runFOPDTAnalysis(const std::string& sensorName)
+void StepTrigger::logNote(const std::string& text)
 {
-    auto data = prepareAnalysisData();
-
-    auto paramsLSM = process_models::identifyFOPDT(
-        data.times, data.temps, expCfg.initialPwmDuty,
-        expCfg.afterTriggerPwmDuty, data.stepTime, data.startMean,
-        data.endMean);
-
-    auto params632 = process_models::identifyTwoPoint(
-        data.times, data.temps, expCfg.initialPwmDuty,
-        expCfg.afterTriggerPwmDuty, data.stepTime, data.startMean,
-        data.endMean);
-
-    auto paramsOpt = process_models::identifyOptimization(
-        data.times, data.temps, expCfg.initialPwmDuty,
-        expCfg.afterTriggerPwmDuty, data.stepTime, data.startMean,
-        data.endMean);
-
-    std::string filename = logDir + "/fopdt_" + sensorName + ".txt";
-    std::ofstream fFile(filename);
-    fFile << "Name:" << sensorName << "\n\n";
-
-    fFile << "------632 Method--------\n";
-    fFile << "k=" << params632.k << "\n";
-    fFile << "tau=" << params632.tau << "\n";
-    fFile << "theta=" << params632.theta << "\n\n";
-
-    fFile << "------LSM Method--------\n";
-    fFile << "k=" << paramsLSM.k << "\n";
-    fFile << "tau=" << paramsLSM.tau << "\n";
-    fFile << "theta=" << paramsLSM.theta << "\n\n";
-
-    fFile << "------Optimization Method--------\n";
-    fFile << "k=" << paramsOpt.k << "\n";
-    fFile << "tau=" << paramsOpt.tau << "\n";
-    fFile << "theta=" << paramsOpt.theta << "\n";
+    for (auto& w : logWriters)
+        w->note(text);
 }
 
 } // namespace autotune::experiment
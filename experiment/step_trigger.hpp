@@ -1,12 +1,22 @@
 #pragma once
 
 #include "../buildjson/config.hpp"
-
-#include <sdbusplus/bus.hpp>
-
+#include "../core/backend.hpp"
+#include "../core/rolling_stats.hpp"
+#include "../core/thread_pool.hpp"
+#include "../process_models/online_fopdt.hpp"
+#include "experiment.hpp"
+#include "journal.hpp"
+#include "log_writer.hpp"
+#include "sample_store.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -22,54 +32,115 @@ enum class State
     Finished
 };
 
-struct DataPoint
-{
-    int64_t n;
-    double time;
-    double temp;
-    double pwm;
-    double slope;
-    double rmse;
-    double mean;
-};
-
-class StepTrigger
+class StepTrigger :
+    public Experiment,
+    public std::enable_shared_from_this<StepTrigger>
 {
   public:
-    StepTrigger(sdbusplus::bus_t& bus,
+    StepTrigger(boost::asio::io_context& io, core::ThreadPool& analysisPool,
                 const std::string& objectPath, // Match definition
                 const config::BasicSetting& basic,
                 const config::ExperimentConfig& exp);
 
-    void tick();
-    void setEnabled(bool enabled);
-    bool getEnabled() const
+    void tick() override;
+    void setEnabled(bool enabled) override;
+    bool getEnabled() const override
     {
         return enabled;
     }
 
+    const std::string& name() const override
+    {
+        return expCfg.tempSensor;
+    }
+
+    /** Fraction of the configured iterations completed by this run. */
+    double progress() const override
+    {
+        const auto total =
+            expCfg.initialIterations + expCfg.afterTriggerIterations;
+        if (total <= 0)
+            return 0.0;
+        return std::min(1.0, static_cast<double>(currentIteration) / total);
+    }
+
+    std::vector<std::string> fans() const override;
+
+    const std::vector<std::string>& sensors() const override
+    {
+        return expCfg.observedSensors;
+    }
+
+    const std::vector<std::string>& coupledSensors() const override
+    {
+        return expCfg.coupledSensors;
+    }
+
+    int priority() const override
+    {
+        return expCfg.priority;
+    }
+
+    size_t logQueueDepth() const override
+    {
+        size_t depth = 0;
+        for (const auto& w : logWriters)
+            depth += w->queueDepth();
+        return depth;
+    }
+
+    uint64_t logDropped() const override
+    {
+        uint64_t n = 0;
+        for (const auto& w : logWriters)
+            n += w->dropped();
+        return n;
+    }
+
+    const process_models::OnlineFOPDTEstimate& onlineEstimate() const
+    {
+        return online.estimate();
+    }
+
+    /** Called after every sample that updates the online estimate. */
+    void onOnlineEstimateChanged(std::function<void()> cb)
+    {
+        onlineEstimateChanged = std::move(cb);
+    }
+
+    /**
+     * @brief Pick up a run that a crash interrupted, from its journal.
+     *
+     * The journaled samples are replayed; sampling then resumes in the
+     * recorded phase, or the analysis runs if sampling had finished.
+     * @return true if a run was recovered.
+     */
+    bool resume();
+
   private:
+    void resetRun();
     void start();
     void stop();
     void iteration();
+    void recordSample(const std::vector<std::optional<double>>& temps,
+                      std::chrono::steady_clock::time_point completed);
+    void writePwm(const std::vector<std::string>& fans, double duty,
+                  io::WriteHandler onDone = nullptr);
+    void recordStepWindow(const io::WriteResult& result);
+    bool phaseSettled(double time);
+    bool onlineConverged(double time, double temp);
+    void endPhase(const char* phase, const char* reason, double time);
     void finishExperiment();
-    void runAnalysis();
-
-    // Sub-analysis functions
-    void runNoiseAnalysis(const std::string& sensorName);
-    void runFOPDTAnalysis(const std::string& sensorName);
-
-    struct AnalysisData
-    {
-        std::vector<double> times;
-        std::vector<double> temps;
-        double stepTime;
-        double startMean;
-        double endMean;
-    };
-    AnalysisData prepareAnalysisData();
-
-    sdbusplus::bus_t& bus;
+    std::string logMetadata(const std::string& sensor) const;
+    void logNote(const std::string& text);
+    void submitAnalysis();
+    std::string journalPath() const;
+    uint64_t configTag() const;
+    void journalPhase(double time, double value = 0.0, double aux = 0.0);
+    void discardJournal();
+
+    boost::asio::io_context& io;
+    core::ThreadPool& analysisPool;
     std::string objectPath;
     config::BasicSetting basicCfg;
     config::ExperimentConfig expCfg;
@@ -79,14 +150,41 @@ class StepTrigger
     State state = State::Idle;
 
     int64_t currentIteration = 0;
+    // Index of the first sample taken after the step; -1 before it.
+    int64_t triggerIndex = -1;
+    double phaseStartTime = 0.0;
+    // Time the current phase first looked steady; negative while not.
+    double steadySince = -1.0;
+    // Primary sensor's window mean and RMSE at the step; the after-trigger
+    // phase may only settle once the mean has left that noise band, or
+    // onlineMaxDeadTime has passed.
+    double preStepMean = 0.0;
+    double preStepNoise = 0.0;
+    bool responded = false;
+    // A sensor read is outstanding; the next poll waits for it.
+    bool readInFlight = false;
+    // Bumped on every start() so completions from a previous run are ignored.
+    uint64_t runId = 0;
     std::chrono::time_point<std::chrono::steady_clock> startTime;
     std::chrono::time_point<std::chrono::steady_clock> lastTickTime;
 
-    std::vector<DataPoint> history;
-    std::vector<DataPoint> fullLog;
+    // Step write window relative to startTime; negative until acknowledged.
+    double stepIssuedTime = -1.0;
+    double stepAckedTime = -1.0;
+
+    // One per observed sensor; front() is the step sensor.
+    std::vector<core::RollingStats> stats;
+    process_models::OnlineFOPDT online;
+    // Time the online estimate first met the tolerance; negative while not.
+    double convergedSince = -1.0;
+    std::function<void()> onlineEstimateChanged;
+    SampleStore samples;
+    std::vector<ChannelSample> channelValues; // scratch for recordSample
 
     std::string logDir;
-    std::ofstream logFile;
+    std::vector<std::unique_ptr<LogWriter>> logWriters;
+    // Samples, phase changes and the step window, for resume after a crash.
+    Journal journal;
 };
 
 } // namespace autotune::experiment
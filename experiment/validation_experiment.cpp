@@ -0,0 +1,225 @@
+#include "validation_experiment.hpp"
+
+#include "../core/utils.hpp"
+
+#include <boost/asio/post.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace autotune::experiment
+{
+
+ValidationExperiment::ValidationExperiment(
+    boost::asio::io_context& io, core::ThreadPool& analysisPool,
+    const config::BasicSetting& basic, const config::ValidationConfig& cfg) :
+    PollingExperiment(io, analysisPool, basic, "Validation", "validation",
+                      1),
+    cfg(cfg), sensorList{cfg.tempSensor}, gains{cfg.kp, cfg.ki, cfg.kd},
+    stats(static_cast<size_t>(std::max(basic.windowSize, 1)))
+{
+    if (cfg.model)
+    {
+        process_models::FOPDTParameters model{cfg.model->k, cfg.model->tau,
+                                              cfg.model->theta};
+        gains = process_models::imcPID(model, cfg.imcRatio);
+    }
+}
+
+double ValidationExperiment::progress() const
+{
+    int64_t total = std::max(cfg.settleIterations, 0) +
+                    std::max(cfg.holdIterations, 0);
+    if (total <= 0)
+        return 0.0;
+    return std::min(1.0, static_cast<double>(currentIteration) / total);
+}
+
+bool ValidationExperiment::beginRun()
+{
+    // Gains set from now on wait for the next run.
+    runGains = gains;
+    std::cerr << "[Validation] " << cfg.name << " kp=" << runGains.kp
+              << " ki=" << runGains.ki << " kd=" << runGains.kd << "\n";
+    phase = Phase::Settle;
+    controller.reset();
+    stats.reset();
+    samples.reset(static_cast<size_t>(std::max(cfg.settleIterations, 0) +
+                                      std::max(cfg.holdIterations, 0)),
+                  1, basicCfg.compactStorage);
+
+    writeDuty(cfg.initialPwmDuty);
+    return true;
+}
+
+std::string ValidationExperiment::logMetadata(const std::string&) const
+{
+    nlohmann::json j;
+    j["tempsensor"] = cfg.tempSensor;
+    j["validation"] = cfg.name;
+    j["pollinterval"] = basicCfg.pollInterval;
+    j["windowsize"] = basicCfg.windowSize;
+    j["fans"] = cfg.fans;
+    j["kp"] = runGains.kp;
+    j["ki"] = runGains.ki;
+    j["kd"] = runGains.kd;
+    j["initialpwmduty"] = cfg.initialPwmDuty;
+    j["minpwmduty"] = cfg.minPwmDuty;
+    j["maxpwmduty"] = cfg.maxPwmDuty;
+    j["settleiterations"] = cfg.settleIterations;
+    j["holditerations"] = cfg.holdIterations;
+    return j.dump();
+}
+
+void ValidationExperiment::writeDuty(double duty)
+{
+    currentDuty = duty;
+    writePwm(cfg.fans, duty);
+}
+
+void ValidationExperiment::recordSample(
+    const std::vector<std::optional<double>>& temps, double timestamp)
+{
+    if (!temps.front())
+    {
+        // Never feed a missing reading to the controller, or to the settle
+        // mean its setpoint comes from.
+        std::cerr << "[Validation] " << cfg.name
+                  << " read failed, holding duty\n";
+        return;
+    }
+    double temp = *temps.front();
+
+    stats.push(timestamp, temp);
+    ChannelSample cv{temp, stats.slope(), stats.rmse(), stats.mean()};
+    logWriters.front()->sample(DataPoint{currentIteration, timestamp, temp,
+                                         currentDuty, cv.slope, cv.rmse,
+                                         cv.mean});
+    if (!samples.append(timestamp, currentDuty, {&cv, 1}))
+    {
+        std::cerr << "[Validation] Sample store full for " << cfg.name
+                  << ", sample " << currentIteration << " not kept\n";
+    }
+    currentIteration++;
+
+    if (phase == Phase::Settle)
+    {
+        if (currentIteration >= cfg.settleIterations)
+            closeLoop(timestamp, temp);
+        lastTime = timestamp;
+        return;
+    }
+
+    double dt = timestamp - lastTime;
+    lastTime = timestamp;
+    double out = controller->update(setpoint, temp, dt);
+    writeDuty(core::scalePwmToRaw(out));
+
+    if (currentIteration >= static_cast<int64_t>(cfg.settleIterations) +
+                                cfg.holdIterations)
+        finish();
+}
+
+void ValidationExperiment::closeLoop(double time, double temp)
+{
+    startTemp = stats.full() ? stats.mean() : temp;
+    setpoint = cfg.setpoint.value_or(startTemp + cfg.setpointStep);
+    stepTime = time;
+
+    controller.emplace(
+        runGains.kp, runGains.ki, runGains.kd,
+        core::scaleRawToDuty(static_cast<int>(cfg.minPwmDuty)),
+        core::scaleRawToDuty(static_cast<int>(cfg.maxPwmDuty)));
+    controller->reset(core::scaleRawToDuty(static_cast<int>(currentDuty)),
+                      temp);
+    phase = Phase::Loop;
+
+    std::cerr << "[Validation] " << cfg.name << " loop closed, setpoint "
+              << setpoint << "\n";
+    std::ostringstream line;
+    line << "#loop_start=" << time << ",setpoint=" << setpoint
+         << ",kp=" << runGains.kp << ",ki=" << runGains.ki
+         << ",kd=" << runGains.kd;
+    logNote(line.str());
+    logSync();
+}
+
+void ValidationExperiment::finish()
+{
+    std::cout << "[Validation] Finished " << cfg.name << "\n";
+    writeDuty(cfg.initialPwmDuty);
+    controller.reset();
+    logNote("#loop_end");
+
+    struct Job
+    {
+        std::string path;
+        std::string name;
+        process_models::PIDGains gains;
+        double startTemp;
+        double setpoint;
+        double stepTime;
+        double band;
+        double maxOvershoot;
+        double maxSettlingTime;
+        std::shared_ptr<const SampleStore> samples;
+    };
+
+    auto job = std::make_shared<Job>();
+    job->path = logDir + "/validation_" + cfg.name + ".txt";
+    job->name = cfg.name;
+    job->gains = runGains;
+    job->startTemp = startTemp;
+    job->setpoint = setpoint;
+    job->stepTime = stepTime;
+    job->band = cfg.settleBand;
+    job->maxOvershoot = cfg.maxOvershoot;
+    job->maxSettlingTime = cfg.maxSettlingTime;
+    job->samples = std::make_shared<const SampleStore>(std::move(samples));
+
+    endRun([job, weak = weakSelf(this), &ioc = io] {
+        const auto& s = *job->samples;
+        std::vector<double> duty(s.size());
+        for (size_t i = 0; i < s.size(); ++i)
+            duty[i] = core::scaleRawToDuty(static_cast<int>(s.at(i).pwm));
+
+        auto m = computeLoopMetrics(s.times(), s.temps(), duty,
+                                    job->stepTime, job->startTemp,
+                                    job->setpoint, job->band);
+        bool pass = m.valid && m.settlingTime >= 0 &&
+                    m.overshoot <= job->maxOvershoot &&
+                    (job->maxSettlingTime <= 0 ||
+                     m.settlingTime <= job->maxSettlingTime);
+
+        std::ofstream out(job->path);
+        out << "Name:" << job->name << "\n";
+        out << "kp=" << job->gains.kp << "\n";
+        out << "ki=" << job->gains.ki << "\n";
+        out << "kd=" << job->gains.kd << "\n";
+        out << "Start=" << job->startTemp << "\n";
+        out << "Setpoint=" << job->setpoint << "\n\n";
+        out << "------Response--------\n";
+        out << "RiseTime=" << m.riseTime << "\n";
+        out << "Overshoot=" << m.overshoot << "\n";
+        out << "SettlingTime=" << m.settlingTime << "\n";
+        out << "IAE=" << m.iae << "\n";
+        out << "Effort=" << m.effort << "\n";
+        out << "MeanDuty=" << m.meanDuty << "\n";
+        out << "Passed=" << (pass ? "true" : "false") << "\n";
+
+        boost::asio::post(ioc, [weak, m, pass] {
+            if (auto self = weak.lock())
+            {
+                self->lastMetrics = m;
+                self->lastPassed = pass;
+                if (self->metricsChanged)
+                    self->metricsChanged();
+            }
+        });
+    });
+}
+
+} // namespace autotune::experiment
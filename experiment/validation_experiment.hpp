@@ -0,0 +1,130 @@
+#pragma once
+
+#include "../buildjson/config.hpp"
+#include "../core/pid_controller.hpp"
+#include "../core/rolling_stats.hpp"
+#include "../core/thread_pool.hpp"
+#include "../process_models/pid_tuning.hpp"
+#include "loop_metrics.hpp"
+#include "polling_experiment.hpp"
+#include "sample_store.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace autotune::experiment
+{
+
+/**
+ * @brief Closed-loop validation of a PID tuning.
+ *
+ * Holds the fans at initialPwmDuty for settleIterations, then closes a
+ * PID loop on the sensor at the poll rate and moves the setpoint by
+ * setpointStep (or to setpoint). After holdIterations the fans return to
+ * initialPwmDuty and rise time, overshoot, settling time, IAE and duty
+ * effort are written to validation_<name>.txt and published.
+ */
+class ValidationExperiment : public PollingExperiment
+{
+  public:
+    ValidationExperiment(boost::asio::io_context& io,
+                         core::ThreadPool& analysisPool,
+                         const config::BasicSetting& basic,
+                         const config::ValidationConfig& cfg);
+
+    const std::string& name() const override
+    {
+        return cfg.name;
+    }
+
+    double progress() const override;
+
+    std::vector<std::string> fans() const override
+    {
+        return cfg.fans;
+    }
+
+    const std::vector<std::string>& sensors() const override
+    {
+        return sensorList;
+    }
+
+    const std::vector<std::string>& coupledSensors() const override
+    {
+        return cfg.coupledSensors;
+    }
+
+    int priority() const override
+    {
+        return cfg.priority;
+    }
+
+    /** Gains for the next run; a running loop keeps its own. */
+    const process_models::PIDGains& getGains() const
+    {
+        return gains;
+    }
+
+    void setGains(const process_models::PIDGains& g)
+    {
+        gains = g;
+    }
+
+    /** Scores of the last completed run. */
+    const LoopMetrics& metrics() const
+    {
+        return lastMetrics;
+    }
+
+    bool passed() const
+    {
+        return lastPassed;
+    }
+
+    void onMetricsChanged(std::function<void()> cb)
+    {
+        metricsChanged = std::move(cb);
+    }
+
+  private:
+    enum class Phase
+    {
+        Settle,
+        Loop
+    };
+
+    bool beginRun() override;
+    void recordSample(const std::vector<std::optional<double>>& temps,
+                      double timestamp) override;
+    std::string logMetadata(const std::string& sensor) const override;
+    void closeLoop(double time, double temp);
+    void finish();
+    void writeDuty(double duty);
+
+    config::ValidationConfig cfg;
+    std::vector<std::string> sensorList;
+    process_models::PIDGains gains;
+    // Gains of the current run, fixed when it starts.
+    process_models::PIDGains runGains;
+
+    Phase phase = Phase::Settle;
+    double setpoint = 0.0;
+    double startTemp = 0.0;
+    double stepTime = 0.0;
+    double lastTime = 0.0;
+    double currentDuty = 0.0; // raw PWM
+    std::optional<core::PIDController> controller;
+
+    core::RollingStats stats;
+    SampleStore samples;
+
+    LoopMetrics lastMetrics;
+    bool lastPassed = false;
+    std::function<void()> metricsChanged;
+};
+
+} // namespace autotune::experiment
@@ -1,11 +1,22 @@
 #include "buildjson/config.hpp"
+#include "core/backend.hpp"
+#include "core/dbus_io.hpp"
+#include "core/sensor_cache.hpp"
+#include "core/thread_pool.hpp"
+#include "experiment/excitation_experiment.hpp"
+#include "experiment/mimo_experiment.hpp"
+#include "experiment/relay_experiment.hpp"
+#include "experiment/scheduler.hpp"
 #include "experiment/step_trigger.hpp"
+#include "experiment/validation_experiment.hpp"
 
 #include <boost/asio.hpp>
 #include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/asio/object_server.hpp>
 #include <sdbusplus/bus.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <memory>
@@ -29,9 +40,12 @@ int main(int argc, char** argv)
     }
 
     auto cfg = autotune::config::loadConfig(configPath);
-    std::cerr << "Loaded " << cfg.experiments.size() << " experiments from "
-              << configPath << "\n";
-    if (cfg.experiments.empty())
+    size_t configured = cfg.experiments.size() + cfg.mimo.size() +
+                        cfg.relay.size() + cfg.excitation.size() +
+                        cfg.validation.size();
+    std::cerr << "Loaded " << configured << " experiments from " << configPath
+              << "\n";
+    if (configured == 0)
     {
         std::cerr << "No experiments configured.\n";
     }
@@ -47,11 +61,116 @@ int main(int argc, char** argv)
 
     sdbusplus::bus_t& busRef = static_cast<sdbusplus::bus_t&>(*conn);
 
+    // Sensor reads and PWM writes from the experiments run asynchronously
+    // on this connection so a slow daemon never blocks the tick.
+    autotune::dbusio::setConnection(conn);
+    autotune::io::setBackend(autotune::io::makeBackend(cfg));
+
+    // Resolve every configured sensor/fan owner once, keep the cache honest
+    // by watching for owner and interface changes, and subscribe to their
+    // value updates so experiments read them without polling the bus.
+    if (cfg.basic.backend != "hwmon")
+    {
+        std::vector<std::string> temps;
+        std::vector<std::string> fans;
+        for (const auto& expCfg : cfg.experiments)
+        {
+            temps.insert(temps.end(), expCfg.observedSensors.begin(),
+                         expCfg.observedSensors.end());
+            fans.insert(fans.end(), expCfg.initialFanSensors.begin(),
+                        expCfg.initialFanSensors.end());
+            fans.insert(fans.end(), expCfg.afterTriggerFanSensors.begin(),
+                        expCfg.afterTriggerFanSensors.end());
+        }
+        for (const auto& mimoCfg : cfg.mimo)
+        {
+            temps.insert(temps.end(), mimoCfg.sensors.begin(),
+                         mimoCfg.sensors.end());
+            for (const auto& group : mimoCfg.fanGroups)
+                fans.insert(fans.end(), group.fans.begin(), group.fans.end());
+        }
+        for (const auto& relayCfg : cfg.relay)
+        {
+            temps.push_back(relayCfg.tempSensor);
+            fans.insert(fans.end(), relayCfg.fans.begin(),
+                        relayCfg.fans.end());
+        }
+        for (const auto& excCfg : cfg.excitation)
+        {
+            temps.push_back(excCfg.tempSensor);
+            fans.insert(fans.end(), excCfg.fans.begin(), excCfg.fans.end());
+        }
+        for (const auto& valCfg : cfg.validation)
+        {
+            temps.push_back(valCfg.tempSensor);
+            fans.insert(fans.end(), valCfg.fans.begin(), valCfg.fans.end());
+        }
+        autotune::dbusio::watchServiceChanges(busRef);
+        autotune::dbusio::prewarmServiceCache(temps, fans);
+        autotune::dbusio::subscribeSensors(busRef, temps, fans);
+    }
+
     // Captured by shared_ptr to keep alive in lambdas? No, vector of
     // shared_ptrs. We need to ensure the vector persists. It is in main scope.
     // However, the lambda captures it by reference.
 
-    std::vector<std::shared_ptr<autotune::experiment::StepTrigger>> experiments;
+    // Post-experiment identification runs here, off the io_context thread.
+    // Declared before the experiments so queued jobs finish first on exit.
+    autotune::core::ThreadPool analysisPool(3);
+
+    std::vector<std::shared_ptr<autotune::experiment::Experiment>> experiments;
+    // Step experiments journal their runs and can resume after a crash.
+    std::vector<std::shared_ptr<autotune::experiment::StepTrigger>>
+        stepTriggers;
+
+    // Properties every experiment type exposes; the caller adds its own
+    // and initializes the interface.
+    auto addExperimentIface =
+        [&server](const std::shared_ptr<autotune::experiment::Experiment>& exp,
+                  const std::string& objPath, const std::string& ifaceName) {
+            auto iface = server->add_interface(objPath, ifaceName);
+
+            iface->register_property(
+                "Enabled", false,
+                [exp](const bool& req, bool& curr) {
+                    if (req != curr)
+                    {
+                        std::cerr << "[Experiment] " << exp->name()
+                                  << " Enabled set to " << req << "\n";
+                        exp->setEnabled(req);
+                        curr = req;
+                    }
+                    return 1;
+                },
+                [exp](const bool& curr) {
+                    (void)curr;
+                    return exp->getEnabled();
+                });
+
+            // Background log writer health.
+            iface->register_property_r<uint64_t>(
+                "LogQueueDepth", 0, sdbusplus::vtable::property_::none,
+                [exp](const uint64_t&) {
+                    return static_cast<uint64_t>(exp->logQueueDepth());
+                });
+            iface->register_property_r<uint64_t>(
+                "LogDroppedSamples", 0, sdbusplus::vtable::property_::none,
+                [exp](const uint64_t&) { return exp->logDropped(); });
+
+            iface->register_property_r<std::string>(
+                "AnalysisStatus", "Idle",
+                sdbusplus::vtable::property_::emits_change,
+                [exp](const std::string&) {
+                    return autotune::experiment::toString(
+                        exp->getAnalysisStatus());
+                });
+            exp->onAnalysisStatusChanged(
+                [weakIface = std::weak_ptr(iface)] {
+                    if (auto i = weakIface.lock())
+                        i->signal_property("AnalysisStatus");
+                });
+            return iface;
+        };
 
     for (const auto& expCfg : cfg.experiments)
     {
@@ -59,148 +178,251 @@ int main(int argc, char** argv)
             "/xyz/openbmc_project/PIDAutotune/" + expCfg.tempSensor;
 
         auto exp = std::make_shared<autotune::experiment::StepTrigger>(
-            busRef, objPath, cfg.basic, expCfg);
+            *io, analysisPool, objPath, cfg.basic, expCfg);
         experiments.push_back(exp);
+        stepTriggers.push_back(exp);
+
+        auto iface = addExperimentIface(
+            exp, objPath, "xyz.openbmc_project.PIDAutotune.steptrigger");
+
+        // Live recursive FOPDT estimate during AfterTriggerWait.
+        using Estimate = autotune::process_models::OnlineFOPDTEstimate;
+        const std::pair<const char*, double (*)(const Estimate&)> online[] = {
+            {"OnlineK", [](const Estimate& e) { return e.params.k; }},
+            {"OnlineTau", [](const Estimate& e) { return e.params.tau; }},
+            {"OnlineTheta", [](const Estimate& e) { return e.params.theta; }},
+            {"OnlineKStdDev", [](const Estimate& e) { return e.kStd; }},
+            {"OnlineTauStdDev", [](const Estimate& e) { return e.tauStd; }},
+            {"OnlineThetaStdDev",
+             [](const Estimate& e) { return e.thetaStd; }}};
+        for (const auto& [name, get] : online)
+        {
+            iface->register_property_r<double>(
+                name, 0.0, sdbusplus::vtable::property_::emits_change,
+                [exp, get](const double&) {
+                    return get(exp->onlineEstimate());
+                });
+        }
+        iface->register_property_r<bool>(
+            "OnlineValid", false, sdbusplus::vtable::property_::emits_change,
+            [exp](const bool&) { return exp->onlineEstimate().valid; });
+        exp->onOnlineEstimateChanged([weakIface = std::weak_ptr(iface),
+                                      online] {
+            if (auto i = weakIface.lock())
+            {
+                for (const auto& entry : online)
+                    i->signal_property(entry.first);
+                i->signal_property("OnlineValid");
+            }
+        });
 
-        auto iface = server->add_interface(
-            objPath, "xyz.openbmc_project.PIDAutotune.steptrigger");
+        iface->initialize();
+    }
 
-        iface->register_property(
-            "Enabled", false,
-            [exp](const bool& req, bool& curr) {
-                if (req != curr)
-                {
-                    std::cerr << "[StepTrigger] Individual Enabled set to "
-                              << req << "\n";
-                    exp->setEnabled(req);
-                    curr = req;
-                }
-                return 1;
-            },
-            [exp](const bool& curr) {
-                (void)curr;
-                return exp->getEnabled();
-            });
+    for (const auto& mimoCfg : cfg.mimo)
+    {
+        auto exp = std::make_shared<autotune::experiment::MimoExperiment>(
+            *io, analysisPool, cfg.basic, mimoCfg);
+        experiments.push_back(exp);
+
+        auto iface = addExperimentIface(
+            exp, "/xyz/openbmc_project/PIDAutotune/" + mimoCfg.name,
+            "xyz.openbmc_project.PIDAutotune.mimo");
+        iface->initialize();
+    }
+
+    for (const auto& relayCfg : cfg.relay)
+    {
+        auto exp = std::make_shared<autotune::experiment::RelayExperiment>(
+            *io, analysisPool, cfg.basic, relayCfg);
+        experiments.push_back(exp);
 
+        auto iface = addExperimentIface(
+            exp, "/xyz/openbmc_project/PIDAutotune/" + relayCfg.name,
+            "xyz.openbmc_project.PIDAutotune.relay");
         iface->initialize();
     }
 
-    std::shared_ptr<sdbusplus::asio::dbus_interface> allTempsIface;
-    bool allEnabled = false;
+    for (const auto& excCfg : cfg.excitation)
+    {
+        auto exp =
+            std::make_shared<autotune::experiment::ExcitationExperiment>(
+                *io, analysisPool, cfg.basic, excCfg);
+        experiments.push_back(exp);
+
+        auto iface = addExperimentIface(
+            exp, "/xyz/openbmc_project/PIDAutotune/" + excCfg.name,
+            "xyz.openbmc_project.PIDAutotune.excitation");
+        iface->initialize();
+    }
+
+    for (const auto& valCfg : cfg.validation)
+    {
+        auto exp =
+            std::make_shared<autotune::experiment::ValidationExperiment>(
+                *io, analysisPool, cfg.basic, valCfg);
+        experiments.push_back(exp);
+
+        auto iface = addExperimentIface(
+            exp, "/xyz/openbmc_project/PIDAutotune/" + valCfg.name,
+            "xyz.openbmc_project.PIDAutotune.validation");
+
+        // Gains for the next run, e.g. from another tuning pass.
+        using Gains = autotune::process_models::PIDGains;
+        const std::pair<const char*, double Gains::*> gains[] = {
+            {"Kp", &Gains::kp}, {"Ki", &Gains::ki}, {"Kd", &Gains::kd}};
+        for (const auto& [name, field] : gains)
+        {
+            iface->register_property(
+                name, exp->getGains().*field,
+                [exp, field](const double& req, double& curr) {
+                    auto g = exp->getGains();
+                    g.*field = req;
+                    exp->setGains(g);
+                    curr = req;
+                    return 1;
+                },
+                [exp, field](const double&) {
+                    return exp->getGains().*field;
+                });
+        }
+
+        // Scores of the last run.
+        using Metrics = autotune::experiment::LoopMetrics;
+        const std::pair<const char*, double Metrics::*> scores[] = {
+            {"RiseTime", &Metrics::riseTime},
+            {"Overshoot", &Metrics::overshoot},
+            {"SettlingTime", &Metrics::settlingTime},
+            {"IAE", &Metrics::iae},
+            {"Effort", &Metrics::effort}};
+        for (const auto& [name, field] : scores)
+        {
+            iface->register_property_r<double>(
+                name, 0.0, sdbusplus::vtable::property_::emits_change,
+                [exp, field](const double&) { return exp->metrics().*field; });
+        }
+        iface->register_property_r<bool>(
+            "Passed", false, sdbusplus::vtable::property_::emits_change,
+            [exp](const bool&) { return exp->passed(); });
+        exp->onMetricsChanged([weakIface = std::weak_ptr(iface), scores] {
+            if (auto i = weakIface.lock())
+            {
+                for (const auto& entry : scores)
+                    i->signal_property(entry.first);
+                i->signal_property("Passed");
+            }
+        });
+
+        iface->initialize();
+    }
 
-    int currentExpIdx = -1; // -1 means no sequence running
+    // "alltempsensor" runs the whole batch, in parallel where the
+    // experiments share no fans or sensors.
+    autotune::experiment::Scheduler scheduler(experiments);
 
     {
         std::string objPath = "/xyz/openbmc_project/PIDAutotune/alltempsensor";
-        allTempsIface = server->add_interface(
+        auto allTempsIface = server->add_interface(
             objPath, "xyz.openbmc_project.PIDAutotune.steptrigger");
 
         allTempsIface->register_property(
             "Enabled", false,
-            [&experiments, &allEnabled,
-             &currentExpIdx](const bool& req, bool& curr) {
-                if (req == curr)
+            [&scheduler, &experiments](const bool& req, bool& curr) {
+                if (req == scheduler.active())
                     return 1;
-                curr = req;
-                allEnabled = req;
 
                 std::cerr << "[AllTempSensor] Enabled set to " << req
                           << ". Experiment count: " << experiments.size()
                           << "\n";
 
                 if (req)
-                {
-                    // Start Sequence
-                    currentExpIdx = 0;
-                    if (!experiments.empty())
-                    {
-                        std::cerr
-                            << "[AllTempSensor] Starting sequence with experiment 0\n";
-                        experiments[0]->setEnabled(true);
-                    }
-                    else
-                    {
-                        std::cerr << "[AllTempSensor] No experiments to run.\n";
-                        allEnabled = false;
-                        curr = false;
-                        currentExpIdx = -1;
-                    }
-                }
+                    scheduler.start();
                 else
-                {
-                    // Stop All
-                    currentExpIdx = -1;
-                    for (auto& e : experiments)
-                        e->setEnabled(false);
-                }
+                    scheduler.stop();
+                curr = scheduler.active();
                 return 1;
+            },
+            [&scheduler](const bool&) { return scheduler.active(); });
+
+        allTempsIface->register_property_r<std::vector<std::string>>(
+            "Queue", {}, sdbusplus::vtable::property_::emits_change,
+            [&scheduler](const std::vector<std::string>&) {
+                return scheduler.queued();
+            });
+        allTempsIface->register_property_r<std::vector<std::string>>(
+            "Running", {}, sdbusplus::vtable::property_::emits_change,
+            [&scheduler](const std::vector<std::string>&) {
+                return scheduler.running();
             });
+        allTempsIface->register_property_r<double>(
+            "Progress", 0.0, sdbusplus::vtable::property_::emits_change,
+            [&scheduler](const double&) { return scheduler.progress(); });
+
+        scheduler.onChanged([weakIface = std::weak_ptr(allTempsIface)] {
+            if (auto i = weakIface.lock())
+            {
+                i->signal_property("Enabled");
+                i->signal_property("Queue");
+                i->signal_property("Running");
+                i->signal_property("Progress");
+            }
+        });
+
         allTempsIface->initialize();
     }
 
+    // Pick up whatever a crash interrupted: each step experiment from its
+    // own journal first, then the batch around them.
+    for (auto& exp : stepTriggers)
+        exp->resume();
+    scheduler.resume();
+
     auto timer = std::make_shared<boost::asio::steady_timer>(*io);
 
+    // Tick at least as often as the fastest poll so sub-100 ms intervals
+    // are honoured.
+    const auto tickPeriod =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::duration<double>(
+                std::clamp(cfg.basic.pollInterval, 0.01, 0.1)));
+
     std::function<void(const boost::system::error_code&)> tick;
     tick = [&](const boost::system::error_code& ec) {
         if (ec)
             return;
 
-        bool anyRunning = false;
         for (auto& exp : experiments)
-        {
             exp->tick();
-            if (exp->getEnabled())
-                anyRunning = true;
-        }
 
-        // Sequential Logic Manager
-        if (allEnabled && currentExpIdx >= 0)
-        {
-            // Check if current experiment is still running
-            if (currentExpIdx < (int)experiments.size())
-            {
-                if (!experiments[currentExpIdx]->getEnabled())
-                {
-                    // Current finished, start next
-                    currentExpIdx++;
-                    if (currentExpIdx < (int)experiments.size())
-                    {
-                        std::cerr
-                            << "[AllTempSensor] Starting next experiment: "
-                            << currentExpIdx << "\n";
-                        experiments[currentExpIdx]->setEnabled(true);
-                    }
-                    else
-                    {
-                        // End of sequence
-                        std::cerr
-                            << "[AllTempSensor] All experiments finished. Sequence complete.\n";
-                        allEnabled = false;
-                        allTempsIface->set_property("Enabled", false);
-                        currentExpIdx = -1;
-                    }
-                }
-            }
-        }
-        else if (allEnabled && !anyRunning && currentExpIdx == -1)
-        {
-            // Fallback for safety if somehow state gets weird, roughly original
-            // logic but stricter
-            std::cerr
-                << "[AllTempSensor] No experiments running and logic reset. Resetting Enabled.\n";
-            allEnabled = false;
-            allTempsIface->set_property("Enabled", false);
-        }
+        scheduler.tick();
 
-        timer->expires_after(std::chrono::milliseconds(100));
+        timer->expires_after(tickPeriod);
         timer->async_wait(tick);
     };
 
-    timer->expires_after(std::chrono::milliseconds(100));
+    timer->expires_after(tickPeriod);
     timer->async_wait(tick);
 
+    // Stop experiments on SIGTERM/SIGINT so their log writers drain and
+    // fsync and their fans go back to automatic control before the process
+    // exits.
+    boost::asio::signal_set signals(*io, SIGINT, SIGTERM);
+    signals.async_wait([&](const boost::system::error_code& ec, int sig) {
+        if (ec)
+            return;
+        std::cerr << "Received signal " << sig << ", stopping experiments\n";
+        scheduler.stop();
+        for (auto& e : experiments)
+            e->setEnabled(false);
+        io->stop();
+    });
+
     std::cout << "Service started.\n";
     io->run();
 
+    // The experiments stopped above released their fans; this returns any
+    // that are still in manual mode to the platform's thermal control.
+    autotune::io::setBackend(nullptr);
+
     return 0;
 }
@@ -1,19 +1,26 @@
 #include "fopdt.hpp"
 
+#include "fopdt_kernel.hpp"
+
 #include "../core/utils.hpp"
 #include "../solvers/least_squares.hpp"
+#include "../solvers/levenberg_marquardt.hpp"
 #include "../solvers/nelder_mead.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
 
 namespace autotune::process_models
 {
 
 static void getFOPDTTemperatures(
-    const std::vector<double>& timeSamples,
-    const std::vector<double>& temperatureSamples, double stepTime,
+    std::span<const double> timeSamples,
+    std::span<const double> temperatureSamples, double stepTime,
     double overrideInitialTemp, double overrideFinalTemp,
     double& initialTemperature, double& finalTemperature)
 {
@@ -46,8 +53,8 @@ static void getFOPDTTemperatures(
 }
 
 FOPDTParameters identifyTwoPoint(
-    const std::vector<double>& timeSamples,
-    const std::vector<double>& temperatureSamples, double initialPwmRaw,
+    std::span<const double> timeSamples,
+    std::span<const double> temperatureSamples, double initialPwmRaw,
     double stepPwmRaw, double stepTime, double overrideInitialTemp,
     double overrideFinalTemp)
 {
@@ -122,8 +129,8 @@ FOPDTParameters identifyTwoPoint(
     return params;
 }
 
-FOPDTParameters identifyFOPDT(const std::vector<double>& timeSamples,
-                              const std::vector<double>& temperatureSamples,
+FOPDTParameters identifyFOPDT(std::span<const double> timeSamples,
+                              std::span<const double> temperatureSamples,
                               double initialPwmRaw, double stepPwmRaw,
                               double stepTime, double overrideInitialTemp,
                               double overrideFinalTemp)
@@ -190,37 +197,81 @@ FOPDTParameters identifyFOPDT(const std::vector<double>& timeSamples,
     return params;
 }
 
-// Helper: SSD Cost Function
-static double calculateSSD(const std::vector<double>& time,
-                           const std::vector<double>& temp, double k_process,
-                           double tau, double theta, double stepTime,
-                           double initialTemp)
+using StepLM = solvers::LevenbergMarquardt<3>;
+
+// Least squares on [kStep, tau, theta] by Levenberg-Marquardt. The model's
+// kink at t = theta has no derivative, so the time since the dead time ends
+// is taken as softplus(t - stepTime - theta) of width w. A width of one
+// sample interval gives theta a gradient from the first fit on; the result
+// is then refined at a tenth of that, where the smoothing is well below
+// the sampling resolution. tau and theta are kept within [lower, upper].
+static StepLM::Result fitStepLM(
+    std::span<const double> time, std::span<const double> temp,
+    StepLM::Vector p, double stepTime, double initialTemp,
+    const StepLM::Vector& lower = {-std::numeric_limits<double>::infinity(),
+                                   0.1, 0.0},
+    const StepLM::Vector& upper = {std::numeric_limits<double>::infinity(),
+                                   std::numeric_limits<double>::infinity(),
+                                   std::numeric_limits<double>::infinity()})
 {
-    double ssd = 0.0;
-    for (size_t i = 0; i < time.size(); ++i)
+    StepLM::Result res;
+    res.params = p;
+    if (time.size() < 2)
+        return res;
+
+    auto opt = StepLM::defaults();
+    opt.maxIter = 100;
+    opt.lower = lower;
+    opt.upper = upper;
+
+    double dt = (time.back() - time.front()) /
+                static_cast<double>(time.size() - 1);
+    for (double w : {dt, 0.1 * dt})
     {
-        double t = time[i];
-        double y_meas = temp[i];
+        if (!(w > 0.0))
+            break;
+        auto residual = [&](const StepLM::Vector& q, size_t i,
+                            StepLM::Vector& g) {
+            double x = (time[i] - stepTime - q[2]) / w;
+            double s = x > 30.0 ? x * w : w * std::log1p(std::exp(x));
+            double ds = 1.0 / (1.0 + std::exp(-x)); // d s / d(t - theta)
+            double e = std::exp(-s / q[1]);
+            g[0] = 1.0 - e;
+            g[1] = -q[0] * e * s / (q[1] * q[1]);
+            g[2] = -q[0] * e * ds / q[1];
+            return initialTemp + q[0] * (1.0 - e) - temp[i];
+        };
+        res = StepLM::solve(res.params, time.size(), residual, opt);
+    }
+    return res;
+}
 
-        // Model: y(t) given k_process (Temperature Gain of the step)
-        double y_pred = initialTemp;
-        if (t >= stepTime + theta)
-        {
-            y_pred =
-                initialTemp +
-                k_process * (1.0 - std::exp(-(t - stepTime - theta) / tau));
-        }
+// Local least-squares fit of [kStep, tau, theta] from one start.
+static std::array<double, 3> refineStep(std::span<const double> time,
+                                        std::span<const double> temp,
+                                        const StepSSD& ssd,
+                                        std::array<double, 3> start,
+                                        double stepTime, double initialTemp,
+                                        FitSolver solver)
+{
+    if (solver == FitSolver::LevenbergMarquardt)
+        return fitStepLM(time, temp, start, stepTime, initialTemp).params;
 
-        ssd += (y_meas - y_pred) * (y_meas - y_pred);
-    }
-    return ssd;
+    auto costFunc = [&](const std::array<double, 3>& p) -> double {
+        // Constraint Penalties
+        if (p[1] < 0.1 || p[2] < 0.0)
+            return 1e15;
+
+        return ssd(initialTemp, {p[0], p[1], p[2]});
+    };
+    return solvers::NelderMead::solve(start, costFunc).params;
 }
 
 FOPDTParameters identifyOptimization(
-    const std::vector<double>& timeSamples,
-    const std::vector<double>& temperatureSamples, double initialPwmRaw,
+    std::span<const double> timeSamples,
+    std::span<const double> temperatureSamples, double initialPwmRaw,
     double stepPwmRaw, double stepTime, double overrideInitialTemp,
-    double overrideFinalTemp)
+    double overrideFinalTemp, FitSolver solver)
 {
     FOPDTParameters params;
 
@@ -248,35 +299,564 @@ FOPDTParameters identifyOptimization(
     double tau_guess = (params.tau > 0) ? params.tau : 10.0;
     double theta_guess = (params.theta > 0) ? params.theta : 1.0;
 
-    std::vector<double> initialParams = {k_step_guess, tau_guess, theta_guess};
+    StepSSD ssd(timeSamples, temperatureSamples, stepTime);
+    auto best = refineStep(timeSamples, temperatureSamples, ssd,
+                           {k_step_guess, tau_guess, theta_guess}, stepTime,
+                           initialTemperature, solver);
 
-    // Cost Function wrapper
-    auto costFunc = [&](const std::vector<double>& p) -> double {
-        double k_s = p[0];
-        double t_const = p[1];
-        double t_delay = p[2];
+    params.k = best[0] / dutyChange;
+    params.tau = best[1];
+    params.theta = best[2];
 
-        // Constraint Penalties
-        if (t_const < 0.1 || t_delay < 0.0)
-            return 1e15;
+    return params;
+}
+
+MultiStartFit identifyMultiStart(
+    std::span<const double> timeSamples,
+    std::span<const double> temperatureSamples, double initialPwmRaw,
+    double stepPwmRaw, double stepTime, std::span<const FOPDTParameters> seeds,
+    size_t lhsSeeds, core::ThreadPool* pool, double overrideInitialTemp,
+    double overrideFinalTemp, FitSolver solver)
+{
+    MultiStartFit fit;
+    double initialTemperature, finalTemperature;
+    getFOPDTTemperatures(timeSamples, temperatureSamples, stepTime,
+                         overrideInitialTemp, overrideFinalTemp,
+                         initialTemperature, finalTemperature);
+    double dutyChange =
+        core::scaleRawToDuty(static_cast<int>(stepPwmRaw)) -
+        core::scaleRawToDuty(static_cast<int>(initialPwmRaw));
+    if (std::abs(dutyChange) < 1e-6 || timeSamples.size() < 2 ||
+        timeSamples.back() <= stepTime)
+        return fit;
+
+    using Start = std::array<double, 3>; // kStep, tau, theta
+    std::vector<Start> starts;
+    for (const auto& s : seeds)
+    {
+        // Estimators that failed leave zeros; keep them usable as starts.
+        starts.push_back({s.k * dutyChange, std::max(s.tau, 1.0),
+                          std::max(s.theta, 0.0)});
+    }
 
-        return calculateSSD(timeSamples, temperatureSamples, k_s, t_const,
-                            t_delay, stepTime, initialTemperature);
+    // Latin hypercube over kStep in [0.5, 1.5] x the observed change, tau
+    // log-uniform from one sample to the record after the step, theta in
+    // [0, a quarter of it]. Fixed seed: the same record gives the same
+    // fit.
+    double span = timeSamples.back() - stepTime;
+    double dt = (timeSamples.back() - timeSamples.front()) /
+                static_cast<double>(timeSamples.size() - 1);
+    double tempChange = finalTemperature - initialTemperature;
+    double tauLo = std::max(dt, 0.1);
+    double tauHi = std::max(span, 2.0 * tauLo);
+    std::mt19937 rng(0x46445054);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::array<std::vector<size_t>, 3> strata;
+    for (auto& column : strata)
+    {
+        column.resize(lhsSeeds);
+        std::iota(column.begin(), column.end(), 0);
+        std::shuffle(column.begin(), column.end(), rng);
+    }
+    for (size_t i = 0; i < lhsSeeds; ++i)
+    {
+        auto at = [&](size_t d) {
+            return (static_cast<double>(strata[d][i]) + unit(rng)) /
+                   static_cast<double>(lhsSeeds);
+        };
+        starts.push_back({tempChange * (0.5 + at(0)),
+                          tauLo * std::pow(tauHi / tauLo, at(1)),
+                          0.25 * span * at(2)});
+    }
+    if (starts.empty())
+        return fit;
+
+    // Screen every start in one batched pass over the record and refine
+    // only the cheapest quarter, never fewer than eight: the local fits
+    // cost far more than a cost evaluation each.
+    StepSSD ssd(timeSamples, temperatureSamples, stepTime);
+    std::vector<StepCandidate> candidates;
+    for (const auto& s : starts)
+        candidates.push_back({s[0], s[1], s[2]});
+    std::vector<double> screen(starts.size());
+    ssd.batch(initialTemperature, candidates, screen);
+    std::vector<size_t> order(starts.size());
+    std::iota(order.begin(), order.end(), 0);
+    size_t keep = std::min(starts.size(),
+                           std::max<size_t>(8, starts.size() / 4));
+    std::partial_sort(order.begin(), order.begin() + keep, order.end(),
+                      [&screen](size_t a, size_t b) {
+                          return screen[a] < screen[b];
+                      });
+    std::vector<Start> kept;
+    for (size_t i = 0; i < keep; ++i)
+        kept.push_back(starts[order[i]]);
+    fit.screened = starts.size();
+    starts = std::move(kept);
+
+    std::vector<Start> optima(starts.size());
+    std::vector<double> costs(starts.size());
+    auto refine = [&](size_t i) {
+        optima[i] = refineStep(timeSamples, temperatureSamples, ssd,
+                               starts[i], stepTime, initialTemperature,
+                               solver);
+        costs[i] = ssd(initialTemperature,
+                       {optima[i][0], optima[i][1], optima[i][2]});
     };
+    if (pool)
+        pool->parallelFor(starts.size(), refine);
+    else
+        for (size_t i = 0; i < starts.size(); ++i)
+            refine(i);
+
+    size_t best = static_cast<size_t>(
+        std::min_element(costs.begin(), costs.end()) - costs.begin());
+    fit.best = {optima[best][0] / dutyChange, optima[best][1],
+                optima[best][2]};
+    fit.rmse =
+        std::sqrt(costs[best] / static_cast<double>(timeSamples.size()));
+    fit.starts = starts.size();
+
+    // Optima that fit (almost) as well as the best but sit elsewhere mean
+    // the record does not pin the parameters down.
+    Start lo = optima[best];
+    Start hi = optima[best];
+    for (size_t i = 0; i < optima.size(); ++i)
+    {
+        if (costs[i] > 1.05 * costs[best])
+            continue;
+        fit.agreeing++;
+        for (size_t d = 0; d < 3; ++d)
+        {
+            lo[d] = std::min(lo[d], optima[i][d]);
+            hi[d] = std::max(hi[d], optima[i][d]);
+        }
+    }
+    fit.spread = {std::abs(hi[0] - lo[0]) / std::abs(dutyChange),
+                  hi[1] - lo[1], hi[2] - lo[2]};
+    fit.valid = true;
+    return fit;
+}
+
+// Temperature change of a step of total size kStep, t seconds after it.
+static double stepResponse(double t, double kStep, double tau, double theta)
+{
+    if (t < theta)
+        return 0.0;
+    return kStep * (1.0 - std::exp(-(t - theta) / tau));
+}
+
+// Diagonal of the inverse of the symmetric positive definite m x m matrix
+// @p a (row major, overwritten by its Cholesky factor); empty if @p a is
+// not positive definite.
+static std::vector<double> inverseDiagonal(std::vector<double>& a, size_t m)
+{
+    for (size_t j = 0; j < m; ++j)
+    {
+        double d = a[j * m + j];
+        for (size_t k = 0; k < j; ++k)
+            d -= a[j * m + k] * a[j * m + k];
+        if (!(d > 0.0))
+            return {};
+        a[j * m + j] = std::sqrt(d);
+        for (size_t i = j + 1; i < m; ++i)
+        {
+            double s = a[i * m + j];
+            for (size_t k = 0; k < j; ++k)
+                s -= a[i * m + k] * a[j * m + k];
+            a[i * m + j] = s / a[j * m + j];
+        }
+    }
 
-    // Run Optimization (3 dimensions)
-    auto bestParams = solvers::NelderMead::solve(initialParams, costFunc, 200);
+    // inv(a) = inv(L)' inv(L): its diagonal sums the squared columns of
+    // inv(L), found a unit vector at a time by forward substitution.
+    std::vector<double> diag(m, 0.0);
+    std::vector<double> x(m);
+    for (size_t c = 0; c < m; ++c)
+    {
+        for (size_t i = c; i < m; ++i)
+        {
+            double s = i == c ? 1.0 : 0.0;
+            for (size_t k = c; k < i; ++k)
+                s -= a[i * m + k] * x[k];
+            x[i] = s / a[i * m + i];
+            diag[c] += x[i] * x[i];
+        }
+    }
+    return diag;
+}
 
-    // Map back to FOPDTParameters
-    double best_k_step = bestParams[0];
-    double best_tau = bestParams[1];
-    double best_theta = bestParams[2];
+std::vector<StepSequenceFit> identifyStepSequence(
+    std::span<const double> timeSamples,
+    std::span<const double> temperatureSamples,
+    std::span<const StepInput> steps, double baseline)
+{
+    std::vector<StepSequenceFit> result(steps.size());
+    size_t n = timeSamples.size();
+    if (n != temperatureSamples.size() || n < 4 || steps.empty())
+        return result;
+    double length = timeSamples.back() - timeSamples.front();
+    double dt = length / static_cast<double>(n - 1);
+    if (!(dt > 0.0))
+        return result;
+
+    // First sample of each step's response; steps with fewer than three
+    // samples after them are not fitted.
+    std::vector<size_t> first(steps.size());
+    std::vector<bool> active(steps.size());
+    for (size_t g = 0; g < steps.size(); ++g)
+    {
+        first[g] = static_cast<size_t>(
+            std::lower_bound(timeSamples.begin(), timeSamples.end(),
+                             steps[g].time) -
+            timeSamples.begin());
+        active[g] = n - first[g] >= 3 && std::abs(steps[g].dutyChange) > 1e-6;
+    }
+    auto g0 = static_cast<size_t>(
+        std::find(active.begin(), active.end(), true) - active.begin());
+    if (g0 == steps.size())
+        return result;
+
+    // Per step: [K_step, Tau, Theta], with tau between one sample and the
+    // record length and theta within the record.
+    const StepLM::Vector lower = {-std::numeric_limits<double>::infinity(),
+                                  dt, 0.0};
+    const StepLM::Vector upper = {std::numeric_limits<double>::infinity(),
+                                  length, length};
+    using JointLM = solvers::LevenbergMarquardt<solvers::dynamicSize>;
+    size_t m = 3 * steps.size();
+    auto opt = JointLM::defaults(m);
+    opt.maxIter = 200;
+    for (size_t g = 0; g < steps.size(); ++g)
+    {
+        std::copy(lower.begin(), lower.end(), opt.lower.begin() + 3 * g);
+        std::copy(upper.begin(), upper.end(), opt.upper.begin() + 3 * g);
+    }
 
-    params.k = best_k_step / dutyChange;
-    params.tau = best_tau;
-    params.theta = best_theta;
+    // All steps fitted together from q, each dead time smoothed as in
+    // fitStepLM().
+    auto refine = [&](JointLM::Vector q) {
+        JointLM::Result res;
+        for (double w : {dt, 0.1 * dt})
+        {
+            auto residual = [&](const JointLM::Vector& x, size_t i,
+                                JointLM::Vector& grad) {
+                double model = baseline;
+                for (size_t g = 0; g < steps.size(); ++g)
+                {
+                    double* d = &grad[3 * g];
+                    d[0] = d[1] = d[2] = 0.0;
+                    if (!active[g])
+                        continue;
+                    const double* v = &x[3 * g];
+                    double u = (timeSamples[i] - steps[g].time - v[2]) / w;
+                    double s = u > 30.0 ? u * w : w * std::log1p(std::exp(u));
+                    double ds = 1.0 / (1.0 + std::exp(-u));
+                    double e = std::exp(-s / v[1]);
+                    d[0] = 1.0 - e;
+                    d[1] = -v[0] * e * s / (v[1] * v[1]);
+                    d[2] = -v[0] * e * ds / v[1];
+                    model += v[0] * (1.0 - e);
+                }
+                return model - temperatureSamples[i];
+            };
+            res = JointLM::solve(q, n, residual, opt);
+            q = res.params;
+        }
+        return res;
+    };
 
-    return params;
+    // 1. Seeds. One FOPDT for the whole response from the first step on
+    //    gives a tau shared by every step. Dead times start at zero: one
+    //    past the true value sees no gradient until the smoothed kink
+    //    reaches the response. With those fixed the model is linear in the
+    //    gains, found over each step's whole post-step record however soon
+    //    the next step came: once free per step, and once as one gain per
+    //    duty percent for all of them.
+    std::vector<double> rise(temperatureSamples.begin(),
+                             temperatureSamples.end());
+    for (auto& r : rise)
+        r -= baseline;
+    size_t tail = std::max<size_t>((n - first[g0]) / 10, 1);
+    double kGuess = 0.0;
+    for (size_t i = n - tail; i < n; ++i)
+        kGuess += rise[i];
+    kGuess /= static_cast<double>(tail);
+    double tauGuess = (timeSamples.back() - steps[g0].time) / 3.0;
+    for (size_t i = first[g0]; i < n; ++i)
+    {
+        if (std::abs(rise[i]) >= 0.632 * std::abs(kGuess))
+        {
+            tauGuess = timeSamples[i] - steps[g0].time;
+            break;
+        }
+    }
+    double tau = fitStepLM(timeSamples.subspan(first[g0]),
+                           std::span<const double>(rise).subspan(first[g0]),
+                           {kGuess, std::clamp(tauGuess, dt, length), 0.0},
+                           steps[g0].time, 0.0, lower, upper)
+                     .params[1];
+
+    auto unitResponse = [&](size_t g, size_t i) {
+        return active[g] ? stepResponse(timeSamples[i] - steps[g].time, 1.0,
+                                        tau, 0.0)
+                         : 0.0;
+    };
+    auto gainResidual = [&](const JointLM::Vector& k, size_t i,
+                            JointLM::Vector& grad) {
+        double model = 0.0;
+        for (size_t g = 0; g < steps.size(); ++g)
+        {
+            grad[g] = unitResponse(g, i);
+            model += k[g] * grad[g];
+        }
+        return model - rise[i];
+    };
+    auto gains = JointLM::solve(JointLM::Vector(steps.size(), 0.0), n,
+                                gainResidual, JointLM::defaults(steps.size()))
+                     .params;
+
+    double sxy = 0.0;
+    double sxx = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double x = 0.0;
+        for (size_t g = 0; g < steps.size(); ++g)
+            x += steps[g].dutyChange * unitResponse(g, i);
+        sxy += x * rise[i];
+        sxx += x * x;
+    }
+    double perDuty = sxx > 0.0 ? sxy / sxx : 0.0;
+
+    // 2. Refine from both seeds and keep the better converged fit.
+    JointLM::Result best;
+    bool found = false;
+    for (int seed = 0; seed < 2; ++seed)
+    {
+        JointLM::Vector q(m);
+        for (size_t g = 0; g < steps.size(); ++g)
+        {
+            q[3 * g] = seed ? perDuty * steps[g].dutyChange : gains[g];
+            q[3 * g + 1] = tau;
+            q[3 * g + 2] = 0.0;
+        }
+        auto res = refine(std::move(q));
+        if (res.converged && (!found || res.cost < best.cost))
+        {
+            best = std::move(res);
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        std::cerr << "[FOPDT] Step sequence fit did not converge\n";
+        return result;
+    }
+    const auto& q = best.params;
+
+    // 3. Standard errors from the Gauss-Newton information matrix. Steps
+    //    too close together for the record to tell apart, or that barely
+    //    moved the temperature, show up as a large error on K or tau.
+    //    The small ridge keeps one unresolved step from hiding the rest.
+    std::vector<double> info(m * m, 0.0);
+    std::vector<double> grad(m);
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::fill(grad.begin(), grad.end(), 0.0);
+        for (size_t g = 0; g < steps.size(); ++g)
+        {
+            double s = timeSamples[i] - steps[g].time - q[3 * g + 2];
+            if (!active[g] || s <= 0.0)
+                continue;
+            double e = std::exp(-s / q[3 * g + 1]);
+            grad[3 * g] = 1.0 - e;
+            grad[3 * g + 1] = -q[3 * g] * e * s / (q[3 * g + 1] * q[3 * g + 1]);
+            grad[3 * g + 2] = -q[3 * g] * e / q[3 * g + 1];
+        }
+        for (size_t a = 0; a < m; ++a)
+        {
+            for (size_t b = 0; b <= a; ++b)
+                info[a * m + b] += grad[a] * grad[b];
+        }
+    }
+    for (size_t a = 0; a < m; ++a)
+        info[a * m + a] += 1e-9 * info[a * m + a] + 1e-12;
+    auto var = inverseDiagonal(info, m);
+    if (var.empty())
+        return result;
+
+    double sigma2 = best.cost / static_cast<double>(n > m ? n - m : 1);
+    for (size_t g = 0; g < steps.size(); ++g)
+    {
+        if (!active[g])
+            continue;
+        const double* v = &q[3 * g];
+        result[g].params = {v[0] / steps[g].dutyChange, v[1], v[2]};
+        double kErr = std::sqrt(sigma2 * var[3 * g]);
+        double tauErr = std::sqrt(sigma2 * var[3 * g + 1]);
+        result[g].valid = v[1] < length && kErr <= 0.25 * std::abs(v[0]) &&
+                          tauErr <= 0.25 * v[1];
+    }
+
+    // 4. Overlapping schedule: two responses that start so close together
+    //    that the first has not shown a tenth of itself when the second
+    //    begins cannot be told apart, whatever the fit says.
+    for (size_t g = 0; g < steps.size(); ++g)
+    {
+        for (size_t h = g + 1; h < steps.size(); ++h)
+        {
+            if (!active[g] || !active[h])
+                continue;
+            double onsetG = steps[g].time + q[3 * g + 2];
+            double onsetH = steps[h].time + q[3 * h + 2];
+            double leadTau = onsetG <= onsetH ? q[3 * g + 1] : q[3 * h + 1];
+            if (std::abs(onsetH - onsetG) < -std::log(0.9) * leadTau)
+            {
+                result[g].valid = false;
+                result[h].valid = false;
+            }
+        }
+    }
+    return result;
+}
+
+using RecordLM = solvers::LevenbergMarquardt<4>; // k, tau, theta, baseline
+
+// An FOPDT model driven by a piecewise-constant input, with its
+// derivatives. Between samples the state is advanced exactly, splitting
+// the interval at every delayed input change. The response is linear in k,
+// so the state is simulated for unit gain along with its derivative by
+// tau; delaying the input further only shifts the response, so its
+// derivative by theta is minus its slope.
+static void simulateRecord(std::span<const double> time,
+                           std::span<const InputLevel> input,
+                           const RecordLM::Vector& q,
+                           std::span<double> model,
+                           std::span<RecordLM::Vector> slope)
+{
+    double tau = q[1];
+    double theta = q[2];
+    double u0 = input.front().duty;
+    double z = 0.0;    // unit-gain deviation from baseline
+    double zTau = 0.0; // dz / dtau
+    double tPrev = time.front();
+    size_t j = 0;      // input level in effect at tPrev - theta
+
+    auto advance = [&](double h, double u) {
+        if (h <= 0)
+            return;
+        double a = std::exp(-h / tau);
+        zTau = zTau * a + (z - (u - u0)) * a * h / (tau * tau);
+        z = z * a + (1.0 - a) * (u - u0);
+    };
+
+    for (size_t i = 0; i < time.size(); ++i)
+    {
+        double t = time[i];
+        while (j + 1 < input.size() && input[j + 1].time + theta <= t)
+        {
+            double tc = std::max(input[j + 1].time + theta, tPrev);
+            advance(tc - tPrev, input[j].duty);
+            tPrev = tc;
+            ++j;
+        }
+        advance(t - tPrev, input[j].duty);
+        tPrev = t;
+
+        model[i] = q[3] + q[0] * z;
+        slope[i] = {z, q[0] * zTau, -q[0] * ((input[j].duty - u0) - z) / tau,
+                    1.0};
+    }
+}
+
+RecordFit identifyRecord(std::span<const double> timeSamples,
+                         std::span<const double> temperatureSamples,
+                         std::span<const InputLevel> input,
+                         double baselineGuess)
+{
+    RecordFit fit;
+    size_t n = timeSamples.size();
+    if (n != temperatureSamples.size() || n < 4 || input.empty())
+        return fit;
+
+    double duration = timeSamples.back() - timeSamples.front();
+    if (duration <= 0)
+        return fit;
+
+    // Static gain guess: regress the temperature on the (undelayed) input.
+    double u0 = input.front().duty;
+    double sxy = 0.0;
+    double sxx = 0.0;
+    size_t j = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        while (j + 1 < input.size() && input[j + 1].time <= timeSamples[i])
+            ++j;
+        double du = input[j].duty - u0;
+        sxy += du * (temperatureSamples[i] - baselineGuess);
+        sxx += du * du;
+    }
+    if (sxx < 1e-9)
+        return fit;
+    double kGuess = sxy / sxx;
+    if (std::abs(kGuess) < 1e-6)
+        kGuess = -0.1; // fans cool
+
+    // The whole record is simulated once per parameter set and the
+    // residuals read from it.
+    std::vector<double> model(n);
+    std::vector<RecordLM::Vector> slope(n);
+    RecordLM::Vector simulated;
+    simulated.fill(std::numeric_limits<double>::quiet_NaN());
+    auto residual = [&](const RecordLM::Vector& q, size_t i,
+                        RecordLM::Vector& g) {
+        if (q != simulated)
+        {
+            simulateRecord(timeSamples, input, q, model, slope);
+            simulated = q;
+        }
+        g = slope[i];
+        return model[i] - temperatureSamples[i];
+    };
+
+    double dt = duration / static_cast<double>(n - 1);
+    auto opt = RecordLM::defaults();
+    opt.maxIter = 200;
+    opt.lower = {-std::numeric_limits<double>::infinity(), dt, 0.0,
+                 -std::numeric_limits<double>::infinity()};
+    opt.upper = {std::numeric_limits<double>::infinity(), duration, duration,
+                 std::numeric_limits<double>::infinity()};
+
+    // A slow plant seen through a fast input has optima that trade dead
+    // time for lag, so start from lags spread over the record and keep
+    // the best converged fit.
+    RecordLM::Result best;
+    bool found = false;
+    for (double tau : {duration / 100.0, duration / 30.0, duration / 10.0,
+                       duration / 3.0})
+    {
+        auto res = RecordLM::solve({kGuess, std::max(tau, dt), 0.0,
+                                    baselineGuess},
+                                   n, residual, opt);
+        if (res.converged && (!found || res.cost < best.cost))
+        {
+            best = res;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        std::cerr << "[FOPDT] Record fit did not converge\n";
+        return fit;
+    }
+
+    fit.params.k = best.params[0];
+    fit.params.tau = best.params[1];
+    fit.params.theta = best.params[2];
+    fit.baseline = best.params[3];
+    fit.rmse = std::sqrt(best.cost / static_cast<double>(n));
+    fit.valid = true;
+    return fit;
 }
 
 } // namespace autotune::process_models
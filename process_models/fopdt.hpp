@@ -1,6 +1,9 @@
 #pragma once
 
+#include "../core/thread_pool.hpp"
+
 #include <limits>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -23,7 +26,7 @@ struct FOPDTParameters
  * @param stepTime Time when step occurred
  */
 FOPDTParameters identifyFOPDT(
-    const std::vector<double>& time, const std::vector<double>& temp,
+    std::span<const double> time, std::span<const double> temp,
     double initialPwm, double stepPwm, double stepTime,
     double overrideInitialTemp = std::numeric_limits<double>::infinity(),
     double overrideFinalTemp = std::numeric_limits<double>::infinity());
@@ -32,18 +35,130 @@ FOPDTParameters identifyFOPDT(
  * @brief Identify FOPDT parameters using Two-Point method (63.2% and 28.3%).
  */
 FOPDTParameters identifyTwoPoint(
-    const std::vector<double>& time, const std::vector<double>& temp,
+    std::span<const double> time, std::span<const double> temp,
     double initialPwm, double stepPwm, double stepTime,
     double overrideInitialTemp = std::numeric_limits<double>::infinity(),
     double overrideFinalTemp = std::numeric_limits<double>::infinity());
 
+/** Least-squares fitter used by identifyOptimization(). */
+enum class FitSolver
+{
+    LevenbergMarquardt,
+    NelderMead
+};
+
 /**
- * @brief Identify FOPDT parameters using Nelder-Mead Optimization.
+ * @brief Identify FOPDT parameters by least squares on the step response,
+ *        starting from the Two-Point estimate.
+ *
+ * Levenberg-Marquardt uses analytic derivatives with the dead-time kink
+ * smoothed by a softplus a fraction of a sample wide, and keeps tau and
+ * theta inside their bounds; Nelder-Mead only needs the cost.
  */
 FOPDTParameters identifyOptimization(
-    const std::vector<double>& time, const std::vector<double>& temp,
+    std::span<const double> time, std::span<const double> temp,
     double initialPwm, double stepPwm, double stepTime,
     double overrideInitialTemp = std::numeric_limits<double>::infinity(),
-    double overrideFinalTemp = std::numeric_limits<double>::infinity());
+    double overrideFinalTemp = std::numeric_limits<double>::infinity(),
+    FitSolver solver = FitSolver::LevenbergMarquardt);
+
+struct MultiStartFit
+{
+    FOPDTParameters best;
+    double rmse = 0.0;   // degC, of the best fit
+    size_t screened = 0; // starts costed before refining
+    size_t starts = 0;   // local fits run
+    size_t agreeing = 0; // optima within 5% of the best cost
+    // max - min of k, tau and theta over the agreeing optima: near-equal
+    // fits far apart mean the record does not determine the parameters.
+    FOPDTParameters spread;
+    bool valid = false;
+};
+
+/**
+ * @brief Global step fit: refine many starts and keep the best.
+ *
+ * Starts are @p seeds (e.g. the Two-Point, LSM and Optimization results)
+ * plus a @p lhsSeeds-point Latin hypercube over the plausible k, tau and
+ * theta. All are costed in one StepSSD::batch() pass and the cheapest
+ * quarter (at least eight) refined by @p solver. The refinements run on
+ * @p pool and the calling thread (see ThreadPool::parallelFor, safe from a
+ * pool job), or serially when @p pool is null. Deterministic for a given
+ * record.
+ */
+MultiStartFit identifyMultiStart(
+    std::span<const double> time, std::span<const double> temp,
+    double initialPwm, double stepPwm, double stepTime,
+    std::span<const FOPDTParameters> seeds, size_t lhsSeeds,
+    core::ThreadPool* pool,
+    double overrideInitialTemp = std::numeric_limits<double>::infinity(),
+    double overrideFinalTemp = std::numeric_limits<double>::infinity(),
+    FitSolver solver = FitSolver::LevenbergMarquardt);
+
+/** One step in a multi-step record: when it happened and its size. */
+struct StepInput
+{
+    double time;
+    double dutyChange; // duty percent
+};
+
+struct StepSequenceFit
+{
+    FOPDTParameters params;
+    bool valid = false; // params resolved by the record
+};
+
+/**
+ * @brief Identify one FOPDT per step from a record that holds several
+ *        steps on different inputs, possibly before earlier ones settled.
+ *
+ * The response is modelled as @p baseline plus the superposition of every
+ * step's FOPDT response, with tau between one sample interval and the
+ * record length and theta non-negative. Every step is seeded from its whole
+ * post-step record with a shared tau, then all parameters are refined
+ * jointly by bounded Levenberg-Marquardt.
+ *
+ * A step is valid only if the fit converged, the standard errors of its K
+ * and tau are within 25%, and its response starts clearly apart from every
+ * other step's: steps too close together to separate, or too small to see
+ * in the noise, are reported invalid.
+ *
+ * @return One fit per step, in the order of @p steps.
+ */
+std::vector<StepSequenceFit> identifyStepSequence(
+    std::span<const double> time, std::span<const double> temp,
+    std::span<const StepInput> steps, double baseline);
+
+/** Input level applied from @c time on, duty percent. */
+struct InputLevel
+{
+    double time;
+    double duty;
+};
+
+struct RecordFit
+{
+    FOPDTParameters params;
+    double baseline = 0.0; // temperature at the first input level
+    double rmse = 0.0;     // degC
+    bool valid = false;
+};
+
+/**
+ * @brief Fit one FOPDT model to a whole record driven by an arbitrary
+ *        piecewise-constant input (PRBS, multi-step, staircase...).
+ *
+ * The model is simulated exactly against @p input, starting at rest at
+ * input.front().duty with temperature @c baseline, and K, tau, theta and
+ * the baseline are chosen to minimise the squared error over the record:
+ * bounded Levenberg-Marquardt from several lags, keeping the best
+ * converged fit. The fit is invalid if none converged.
+ *
+ * @param baselineGuess Starting value for the baseline temperature.
+ */
+RecordFit identifyRecord(std::span<const double> time,
+                         std::span<const double> temp,
+                         std::span<const InputLevel> input,
+                         double baselineGuess);
 
 } // namespace autotune::process_models
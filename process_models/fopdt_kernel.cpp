@@ -0,0 +1,283 @@
+#include "fopdt_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+// AVX2 code is built for its own functions only and chosen at run time,
+// so the binary still runs on x86-64 CPUs without it.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define AUTOTUNE_KERNEL_AVX2 1
+#define AUTOTUNE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUTOTUNE_KERNEL_NEON 1
+#endif
+
+namespace autotune::process_models
+{
+
+namespace
+{
+
+// exp(x), x <= 0, for the vector paths: range reduction to |r| <= ln2/2
+// and a degree-11 Taylor polynomial, relative error below 1e-14; 0 below
+// -700.
+constexpr double kLog2e = 1.4426950408889634;
+// ln 2 split so n * kLn2Hi is exact for the n that occur.
+constexpr double kLn2Hi = 6.93147180369123816490e-01;
+constexpr double kLn2Lo = 1.90821492927058770002e-10;
+constexpr double kExpMin = -700.0;
+
+// 1/k! for k = 11 down to 0.
+constexpr double kPoly[] = {
+    1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0,
+    1.0 / 5040.0,     1.0 / 720.0,     1.0 / 120.0,    1.0 / 24.0,
+    1.0 / 6.0,        0.5,             1.0,            1.0};
+
+// One candidate as the tail loops use it: y - model is
+// (y - c) + k e - drift (t - tStep) with c = b + k and
+// e = exp(-(t - t0) invTau).
+struct TailTerms
+{
+    double c;
+    double k;
+    double t0;
+    double invTau;
+    double drift;
+    double tStep;
+};
+
+TailTerms tailTerms(double baseline, const StepCandidate& cand,
+                    double stepTime)
+{
+    return {baseline + cand.kStep, cand.kStep, stepTime + cand.theta,
+            1.0 / cand.tau,        cand.drift, stepTime};
+}
+
+// Samples per block in StepSSD::batch: 2 x 8 KiB of columns stay in L1
+// while every candidate runs over them.
+constexpr size_t kBlock = 512;
+
+#if AUTOTUNE_KERNEL_AVX2
+
+bool haveAVX2()
+{
+    static const bool have = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("fma");
+    }();
+    return have;
+}
+
+AUTOTUNE_TARGET_AVX2 inline __m256d expNonPositive4(__m256d x)
+{
+    x = _mm256_max_pd(x, _mm256_set1_pd(kExpMin));
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(kLog2e)),
+                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(kLn2Hi), x);
+    r = _mm256_fnmadd_pd(n, _mm256_set1_pd(kLn2Lo), r);
+    __m256d p = _mm256_set1_pd(kPoly[0]);
+    for (size_t k = 1; k < std::size(kPoly); ++k)
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(kPoly[k]));
+    __m128i n32 = _mm_add_epi32(_mm256_cvtpd_epi32(n), _mm_set1_epi32(1023));
+    __m256i e = _mm256_cvtepi32_epi64(n32);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(e, 52)));
+}
+
+#elif AUTOTUNE_KERNEL_NEON
+
+inline float64x2_t expNonPositive2(float64x2_t x)
+{
+    x = vmaxq_f64(x, vdupq_n_f64(kExpMin));
+    float64x2_t n = vrndnq_f64(vmulq_f64(x, vdupq_n_f64(kLog2e)));
+    float64x2_t r = vfmsq_f64(x, n, vdupq_n_f64(kLn2Hi));
+    r = vfmsq_f64(r, n, vdupq_n_f64(kLn2Lo));
+    float64x2_t p = vdupq_n_f64(kPoly[0]);
+    for (size_t k = 1; k < std::size(kPoly); ++k)
+        p = vfmaq_f64(vdupq_n_f64(kPoly[k]), p, r);
+    int64x2_t e = vaddq_s64(vcvtq_s64_f64(n), vdupq_n_s64(1023));
+    return vmulq_f64(p, vreinterpretq_f64_s64(vshlq_n_s64(e, 52)));
+}
+
+#endif
+
+#if AUTOTUNE_KERNEL_AVX2
+
+// The vector part of tailSSD(): samples from @p i on, eight at a time,
+// leaving @p i at the first one not summed.
+AUTOTUNE_TARGET_AVX2 double tailVector(const double* t, const double* y,
+                                       size_t& i, size_t last,
+                                       const TailTerms& m)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    const __m256d vt0 = _mm256_set1_pd(m.t0);
+    const __m256d vNegInv = _mm256_set1_pd(-m.invTau);
+    const __m256d vc = _mm256_set1_pd(m.c);
+    const __m256d vk = _mm256_set1_pd(m.k);
+    const __m256d vts = _mm256_set1_pd(m.tStep);
+    const __m256d vd = _mm256_set1_pd(m.drift);
+    for (; i + 8 <= last; i += 8)
+    {
+        __m256d t0v = _mm256_loadu_pd(t + i);
+        __m256d t1v = _mm256_loadu_pd(t + i + 4);
+        __m256d x0 = _mm256_mul_pd(_mm256_sub_pd(t0v, vt0), vNegInv);
+        __m256d x1 = _mm256_mul_pd(_mm256_sub_pd(t1v, vt0), vNegInv);
+        __m256d r0 = _mm256_fmadd_pd(
+            vk, expNonPositive4(x0),
+            _mm256_sub_pd(_mm256_loadu_pd(y + i), vc));
+        __m256d r1 = _mm256_fmadd_pd(
+            vk, expNonPositive4(x1),
+            _mm256_sub_pd(_mm256_loadu_pd(y + i + 4), vc));
+        r0 = _mm256_fnmadd_pd(vd, _mm256_sub_pd(t0v, vts), r0);
+        r1 = _mm256_fnmadd_pd(vd, _mm256_sub_pd(t1v, vts), r1);
+        acc0 = _mm256_fmadd_pd(r0, r0, acc0);
+        acc1 = _mm256_fmadd_pd(r1, r1, acc1);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#elif AUTOTUNE_KERNEL_NEON
+
+// The vector part of tailSSD(): samples from @p i on, four at a time,
+// leaving @p i at the first one not summed.
+double tailVector(const double* t, const double* y, size_t& i, size_t last,
+                  const TailTerms& m)
+{
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    const float64x2_t vt0 = vdupq_n_f64(m.t0);
+    const float64x2_t vNegInv = vdupq_n_f64(-m.invTau);
+    const float64x2_t vc = vdupq_n_f64(m.c);
+    const float64x2_t vts = vdupq_n_f64(m.tStep);
+    for (; i + 4 <= last; i += 4)
+    {
+        float64x2_t t0v = vld1q_f64(t + i);
+        float64x2_t t1v = vld1q_f64(t + i + 2);
+        float64x2_t x0 = vmulq_f64(vsubq_f64(t0v, vt0), vNegInv);
+        float64x2_t x1 = vmulq_f64(vsubq_f64(t1v, vt0), vNegInv);
+        float64x2_t r0 = vfmaq_n_f64(vsubq_f64(vld1q_f64(y + i), vc),
+                                     expNonPositive2(x0), m.k);
+        float64x2_t r1 = vfmaq_n_f64(vsubq_f64(vld1q_f64(y + i + 2), vc),
+                                     expNonPositive2(x1), m.k);
+        r0 = vfmsq_n_f64(r0, vsubq_f64(t0v, vts), m.drift);
+        r1 = vfmsq_n_f64(r1, vsubq_f64(t1v, vts), m.drift);
+        acc0 = vfmaq_f64(acc0, r0, r0);
+        acc1 = vfmaq_f64(acc1, r1, r1);
+    }
+    return vaddvq_f64(vaddq_f64(acc0, acc1));
+}
+
+#endif
+
+// Sum over [first, last) of
+// (temp - b - drift (t - tStep) - k (1 - exp(-(t - t0) / tau)))^2,
+// with every t >= t0.
+double tailSSD(const double* t, const double* y, size_t first, size_t last,
+               const TailTerms& m)
+{
+    size_t i = first;
+    double ssd = 0.0;
+
+#if AUTOTUNE_KERNEL_AVX2
+    if (haveAVX2())
+        ssd = tailVector(t, y, i, last, m);
+#elif AUTOTUNE_KERNEL_NEON
+    ssd = tailVector(t, y, i, last, m);
+#endif
+
+    // Without vector lanes libm's exp beats the polynomial.
+    for (; i < last; ++i)
+    {
+        double r = y[i] - m.c + m.k * std::exp(-(t[i] - m.t0) * m.invTau) -
+                   m.drift * (t[i] - m.tStep);
+        ssd += r * r;
+    }
+    return ssd;
+}
+
+} // namespace
+
+StepSSD::StepSSD(std::span<const double> time, std::span<const double> temp,
+                 double stepTime) :
+    time(time.first(std::min(time.size(), temp.size()))),
+    temp(temp.first(std::min(time.size(), temp.size()))), stepTime(stepTime)
+{
+    if (!this->temp.empty())
+        ref = this->temp.front();
+    size_t n = this->temp.size();
+    sum.assign(n + 1, 0.0);
+    sumSq.assign(n + 1, 0.0);
+    sumS.assign(n + 1, 0.0);
+    sumSSq.assign(n + 1, 0.0);
+    sumDS.assign(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        double d = this->temp[i] - ref;
+        double s = this->time[i] - stepTime;
+        sum[i + 1] = sum[i] + d;
+        sumSq[i + 1] = sumSq[i] + d * d;
+        sumS[i + 1] = sumS[i] + s;
+        sumSSq[i + 1] = sumSSq[i] + s * s;
+        sumDS[i + 1] = sumDS[i] + d * s;
+    }
+}
+
+size_t StepSSD::firstResponding(double theta) const
+{
+    return static_cast<size_t>(
+        std::lower_bound(time.begin(), time.end(), stepTime + theta) -
+        time.begin());
+}
+
+// sum_{i < n} (temp_i - b - drift s_i)^2 = sum (d_i - c - drift s_i)^2
+// with d = temp - ref, c = b - ref.
+double StepSSD::prefixSSD(size_t n, double baseline, double drift) const
+{
+    double c = baseline - ref;
+    double ssd = sumSq[n] - 2.0 * c * sum[n] + static_cast<double>(n) * c * c;
+    if (drift != 0.0)
+        ssd += drift * (drift * sumSSq[n] - 2.0 * sumDS[n] + 2.0 * c * sumS[n]);
+    return ssd;
+}
+
+double StepSSD::operator()(double baseline, const StepCandidate& c) const
+{
+    size_t first = firstResponding(c.theta);
+    return prefixSSD(first, baseline, c.drift) +
+           tailSSD(time.data(), temp.data(), first, time.size(),
+                   tailTerms(baseline, c, stepTime));
+}
+
+void StepSSD::batch(double baseline, std::span<const StepCandidate> candidates,
+                    std::span<double> out) const
+{
+    const size_t m = std::min(candidates.size(), out.size());
+    size_t start = time.size();
+    for (size_t j = 0; j < m; ++j)
+    {
+        size_t first = firstResponding(candidates[j].theta);
+        out[j] = prefixSSD(first, baseline, candidates[j].drift);
+        start = std::min(start, first);
+    }
+
+    for (size_t lo = start; lo < time.size(); lo += kBlock)
+    {
+        size_t hi = std::min(lo + kBlock, time.size());
+        for (size_t j = 0; j < m; ++j)
+        {
+            const auto& c = candidates[j];
+            size_t first = std::max(lo, firstResponding(c.theta));
+            if (first < hi)
+                out[j] += tailSSD(time.data(), temp.data(), first, hi,
+                                  tailTerms(baseline, c, stepTime));
+        }
+    }
+}
+
+} // namespace autotune::process_models
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace autotune::process_models
+{
+
+/**
+ * One candidate step response: total change, time constant, dead time,
+ * and an optional linear drift (degC/s) that is zero at the step.
+ */
+struct StepCandidate
+{
+    double kStep;
+    double tau;
+    double theta;
+    double drift = 0.0;
+};
+
+/**
+ * @brief Sum of squared errors of an FOPDT step model against one record.
+ *
+ *   y(t) = baseline + drift (t - stepTime)            t < stepTime + theta
+ *   y(t) = baseline + drift (t - stepTime)
+ *          + kStep (1 - exp(-(t - stepTime - theta) / tau))
+ *
+ * Built once per fit over contiguous time/temperature columns (time
+ * ascending), it can then be evaluated any number of times. Samples
+ * before the dead time ends are found by binary search and summed in
+ * O(1) from prefix sums, so only the response tail is evaluated. The tail
+ * runs with a polynomial exp, relative error below 1e-14, on AVX2 + FMA
+ * when the x86-64 CPU has them (checked at run time, no build flags) and
+ * on NEON on AArch64. Everything else, 32-bit ARM BMCs included, takes a
+ * scalar libm loop.
+ */
+class StepSSD
+{
+  public:
+    StepSSD(std::span<const double> time, std::span<const double> temp,
+            double stepTime);
+
+    double operator()(double baseline, const StepCandidate& c) const;
+
+    /**
+     * @brief Evaluate several candidates in one pass over the record.
+     *
+     * The record is walked in cache-sized blocks and every candidate is
+     * evaluated on a block before moving on. @p out must hold
+     * candidates.size() values.
+     */
+    void batch(double baseline, std::span<const StepCandidate> candidates,
+               std::span<double> out) const;
+
+    size_t size() const
+    {
+        return time.size();
+    }
+
+  private:
+    size_t firstResponding(double theta) const;
+    double prefixSSD(size_t n, double baseline, double drift) const;
+
+    std::span<const double> time;
+    std::span<const double> temp;
+    double stepTime;
+    // Prefix sums of d = temp - ref and its square, ref = temp[0] to keep
+    // the expansion of sum (y - b)^2 from cancelling, and for the drift of
+    // s = time - stepTime, its square and d s.
+    double ref = 0.0;
+    std::vector<double> sum;
+    std::vector<double> sumSq;
+    std::vector<double> sumS;
+    std::vector<double> sumSSq;
+    std::vector<double> sumDS;
+};
+
+} // namespace autotune::process_models
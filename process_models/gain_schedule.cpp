@@ -0,0 +1,98 @@
+#include "gain_schedule.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace autotune::process_models
+{
+
+std::vector<ScheduleEntry> buildSchedule(std::span<const StepFit> steps,
+                                         double ratio)
+{
+    struct Bucket
+    {
+        double duty;
+        FOPDTParameters sum;
+        int count;
+    };
+
+    std::vector<Bucket> buckets;
+    for (const auto& s : steps)
+    {
+        if (s.params.tau <= 0 || std::abs(s.fromDuty - s.toDuty) < 1e-6)
+            continue;
+
+        double mid = (s.fromDuty + s.toDuty) / 2.0;
+        auto it = std::find_if(buckets.begin(), buckets.end(),
+                               [mid](const Bucket& b) {
+                                   return std::abs(b.duty - mid) < 1e-6;
+                               });
+        if (it == buckets.end())
+        {
+            buckets.push_back({mid, {}, 0});
+            it = buckets.end() - 1;
+        }
+        it->sum.k += s.params.k;
+        it->sum.tau += s.params.tau;
+        it->sum.theta += s.params.theta;
+        it->count++;
+    }
+
+    std::vector<ScheduleEntry> table;
+    table.reserve(buckets.size());
+    for (const auto& b : buckets)
+    {
+        ScheduleEntry e;
+        e.duty = b.duty;
+        e.model.k = b.sum.k / b.count;
+        e.model.tau = b.sum.tau / b.count;
+        e.model.theta = b.sum.theta / b.count;
+        e.pid = imcPID(e.model, ratio);
+        e.pi = imcPI(e.model, ratio);
+        table.push_back(e);
+    }
+    std::sort(table.begin(), table.end(),
+              [](const ScheduleEntry& a, const ScheduleEntry& b) {
+                  return a.duty < b.duty;
+              });
+    return table;
+}
+
+static double lerp(double a, double b, double f)
+{
+    return a + (b - a) * f;
+}
+
+static PIDGains lerp(const PIDGains& a, const PIDGains& b, double f)
+{
+    return {lerp(a.kp, b.kp, f), lerp(a.ki, b.ki, f), lerp(a.kd, b.kd, f)};
+}
+
+ScheduleEntry interpolateSchedule(std::span<const ScheduleEntry> table,
+                                  double duty)
+{
+    if (table.empty())
+        return {};
+    if (duty <= table.front().duty)
+        return table.front();
+    if (duty >= table.back().duty)
+        return table.back();
+
+    auto hi = std::upper_bound(table.begin(), table.end(), duty,
+                               [](double d, const ScheduleEntry& e) {
+                                   return d < e.duty;
+                               });
+    auto lo = hi - 1;
+    double f = (duty - lo->duty) / (hi->duty - lo->duty);
+
+    ScheduleEntry e;
+    e.duty = duty;
+    e.model.k = lerp(lo->model.k, hi->model.k, f);
+    e.model.tau = lerp(lo->model.tau, hi->model.tau, f);
+    e.model.theta = lerp(lo->model.theta, hi->model.theta, f);
+    e.pid = lerp(lo->pid, hi->pid, f);
+    e.pi = lerp(lo->pi, hi->pi, f);
+    return e;
+}
+
+} // namespace autotune::process_models
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "fopdt.hpp"
+#include "pid_tuning.hpp"
+
+#include <span>
+#include <vector>
+
+namespace autotune::process_models
+{
+
+/** FOPDT fitted to one step between two duties (percent). */
+struct StepFit
+{
+    double fromDuty;
+    double toDuty;
+    FOPDTParameters params;
+};
+
+/** Model and gains around one operating point. */
+struct ScheduleEntry
+{
+    double duty = 0.0; // duty percent
+    FOPDTParameters model;
+    PIDGains pid; // IMC PID
+    PIDGains pi;  // IMC improved PI
+};
+
+/**
+ * @brief Turn local step fits into a gain-schedule table.
+ *
+ * Each step describes the plant around the midpoint of its two duties.
+ * Rising and falling steps over the same range are averaged into one
+ * entry, the table is sorted by duty, and the gains of every entry come
+ * from the IMC rules with @p ratio.
+ */
+std::vector<ScheduleEntry> buildSchedule(std::span<const StepFit> steps,
+                                         double ratio);
+
+/**
+ * @brief Model and gains at @p duty, interpolated linearly between the
+ *        neighbouring entries of a sorted table and held at its ends.
+ */
+ScheduleEntry interpolateSchedule(std::span<const ScheduleEntry> table,
+                                  double duty);
+
+} // namespace autotune::process_models
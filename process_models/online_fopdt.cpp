@@ -0,0 +1,185 @@
+#include "online_fopdt.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace autotune::process_models
+{
+
+namespace
+{
+
+// Bounds the per-sample cost at small poll intervals.
+constexpr size_t kMaxCandidates = 256;
+
+} // namespace
+
+bool OnlineFOPDTEstimate::converged(double tol, double resolution) const
+{
+    if (!valid || params.tau <= 0)
+        return false;
+    return kStd <= tol * std::abs(params.k) && tauStd <= tol * params.tau &&
+           thetaStd <= std::max(tol * params.tau, resolution);
+}
+
+void OnlineFOPDT::reset(double stepTime, double baseline, double dutyChange,
+                        double maxDeadTime, double resolution)
+{
+    this->stepTime = stepTime;
+    this->baseline = baseline;
+    this->dutyChange = dutyChange;
+
+    maxDeadTime = std::max(maxDeadTime, 0.0);
+    step = std::max(resolution, maxDeadTime / (kMaxCandidates - 1));
+    if (step <= 0)
+        step = 1.0;
+
+    size_t count = static_cast<size_t>(maxDeadTime / step) + 1;
+    candidates.assign(count, Candidate{});
+    for (size_t i = 0; i < count; ++i)
+        candidates[i].theta = static_cast<double>(i) * step;
+
+    havePrev = false;
+    prevTime = 0.0;
+    prevZ = 0.0;
+    integral = 0.0;
+    total = 0;
+    current = OnlineFOPDTEstimate{};
+}
+
+void OnlineFOPDT::update(double time, double temp)
+{
+    double t = time - stepTime;
+    if (t < 0 || candidates.empty())
+        return;
+
+    double z = temp - baseline;
+    if (!havePrev)
+    {
+        // The response starts at zero at the step itself.
+        havePrev = true;
+        prevTime = 0.0;
+        prevZ = 0.0;
+    }
+
+    double dt = t - prevTime;
+    double newIntegral = integral + 0.5 * (prevZ + z) * dt;
+
+    for (auto& c : candidates)
+    {
+        if (!c.started)
+        {
+            if (t <= c.theta)
+            {
+                c.preRss += z * z;
+                continue;
+            }
+            // Integral up to theta, interpolated inside this sample.
+            double frac = dt > 0 ? (c.theta - prevTime) / dt : 0.0;
+            frac = std::clamp(frac, 0.0, 1.0);
+            double zTheta = prevZ + frac * (z - prevZ);
+            c.integralAtTheta =
+                integral + 0.5 * (prevZ + zTheta) * frac * dt;
+            c.started = true;
+        }
+
+        double x1 = t - c.theta;
+        double x2 = -(newIntegral - c.integralAtTheta);
+        c.s11 += x1 * x1;
+        c.s12 += x1 * x2;
+        c.s22 += x2 * x2;
+        c.r1 += x1 * z;
+        c.r2 += x2 * z;
+        c.zz += z * z;
+        c.n++;
+    }
+
+    integral = newIntegral;
+    prevTime = t;
+    prevZ = z;
+    total++;
+
+    refresh();
+}
+
+void OnlineFOPDT::refresh()
+{
+    fits.assign(candidates.size(), Fit{});
+    size_t best = candidates.size();
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        const auto& c = candidates[i];
+        if (c.n < 3)
+            continue;
+
+        double det = c.s11 * c.s22 - c.s12 * c.s12;
+        if (!(std::abs(det) > 1e-12 * c.s11 * c.s22))
+            continue;
+
+        auto& f = fits[i];
+        f.inv11 = c.s22 / det;
+        f.inv12 = -c.s12 / det;
+        f.inv22 = c.s11 / det;
+        f.b = f.inv11 * c.r1 + f.inv12 * c.r2;
+        f.a = f.inv12 * c.r1 + f.inv22 * c.r2;
+        if (f.a <= 0)
+            continue;
+
+        double rss = c.zz - 2.0 * (f.b * c.r1 + f.a * c.r2) +
+                     f.b * f.b * c.s11 + 2.0 * f.a * f.b * c.s12 +
+                     f.a * f.a * c.s22;
+        f.cost = c.preRss + std::max(rss, 0.0);
+        if (best == candidates.size() || f.cost < fits[best].cost)
+            best = i;
+    }
+
+    current.samples = total;
+    if (best == candidates.size() || total <= 3 || dutyChange == 0)
+    {
+        current.valid = false;
+        return;
+    }
+
+    const auto& f = fits[best];
+    double sigma2 = f.cost / static_cast<double>(total - 3);
+
+    current.params.tau = 1.0 / f.a;
+    current.params.k = f.b / (f.a * dutyChange);
+
+    // Delta method on tau = 1/a and k = b/(a*du).
+    double varA = sigma2 * f.inv22;
+    double varB = sigma2 * f.inv11;
+    double covAB = sigma2 * f.inv12;
+    current.tauStd = std::sqrt(std::max(varA, 0.0)) / (f.a * f.a);
+    double gA = -f.b / (f.a * f.a * dutyChange);
+    double gB = 1.0 / (f.a * dutyChange);
+    current.kStd = std::sqrt(
+        std::max(gA * gA * varA + 2.0 * gA * gB * covAB + gB * gB * varB,
+                 0.0));
+
+    // Theta: likelihood-weighted mean and spread over the candidates,
+    // L ~ (cost / cost_min)^(-N/2) for Gaussian residuals.
+    double sumW = 0.0;
+    double sumT = 0.0;
+    double sumT2 = 0.0;
+    double minCost = std::max(f.cost, std::numeric_limits<double>::min());
+    for (size_t i = 0; i < fits.size(); ++i)
+    {
+        if (!std::isfinite(fits[i].cost))
+            continue;
+        double w = std::exp(-0.5 * static_cast<double>(total) *
+                            std::log(std::max(fits[i].cost, minCost) /
+                                     minCost));
+        double th = candidates[i].theta;
+        sumW += w;
+        sumT += w * th;
+        sumT2 += w * th * th;
+    }
+    double mean = sumT / sumW;
+    current.params.theta = candidates[best].theta;
+    current.thetaStd = std::sqrt(std::max(sumT2 / sumW - mean * mean, 0.0));
+    current.valid = true;
+}
+
+} // namespace autotune::process_models
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "fopdt.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace autotune::process_models
+{
+
+struct OnlineFOPDTEstimate
+{
+    FOPDTParameters params;
+    // One standard deviation of each parameter.
+    double kStd = 0.0;
+    double tauStd = 0.0;
+    double thetaStd = 0.0;
+    size_t samples = 0;
+    bool valid = false;
+
+    /** True when every standard deviation is within @p tol of the estimate
+     *  (theta relative to tau, but never finer than @p resolution). */
+    bool converged(double tol, double resolution) const;
+};
+
+/**
+ * @brief Recursive FOPDT identification of a step response, updated one
+ *        sample at a time.
+ *
+ * For a dead time theta the step response satisfies, after integrating
+ * tau*dy/dt = k*du - (y - y0) from theta to t,
+ *
+ *     y(t) - y0 = b*(t - theta) - a*integral(y - y0),  a = 1/tau,
+ *                                                      b = k*du/tau
+ *
+ * which is linear in (a, b). A bank of least-squares filters, one per
+ * candidate dead time, accumulates the 2x2 normal equations in O(1) per
+ * sample. The candidate with the smallest residual gives k and tau; theta
+ * and its spread come from the likelihood of every candidate.
+ */
+class OnlineFOPDT
+{
+  public:
+    /**
+     * @param stepTime Time the step was applied
+     * @param baseline Temperature before the step
+     * @param dutyChange Step size in duty percent
+     * @param maxDeadTime Largest dead time considered, seconds after step
+     * @param resolution Spacing of the dead time candidates, seconds
+     */
+    void reset(double stepTime, double baseline, double dutyChange,
+               double maxDeadTime, double resolution);
+
+    void update(double time, double temp);
+
+    const OnlineFOPDTEstimate& estimate() const
+    {
+        return current;
+    }
+
+    double resolution() const
+    {
+        return step;
+    }
+
+  private:
+    struct Candidate
+    {
+        double theta = 0.0;
+        bool started = false;
+        double integralAtTheta = 0.0;
+        // Residual of the flat (pre-dead-time) part of the response.
+        double preRss = 0.0;
+        // Normal equations for regressors (t - theta, -integral).
+        double s11 = 0.0, s12 = 0.0, s22 = 0.0;
+        double r1 = 0.0, r2 = 0.0, zz = 0.0;
+        size_t n = 0;
+    };
+
+    struct Fit
+    {
+        double a = 0.0;
+        double b = 0.0;
+        double cost = std::numeric_limits<double>::infinity();
+        double inv11 = 0.0, inv12 = 0.0, inv22 = 0.0;
+    };
+
+    void refresh();
+
+    std::vector<Candidate> candidates;
+    std::vector<Fit> fits; // scratch, reused every update
+    double stepTime = 0.0;
+    double baseline = 0.0;
+    double dutyChange = 0.0;
+    double step = 1.0;
+
+    bool havePrev = false;
+    double prevTime = 0.0;
+    double prevZ = 0.0;
+    double integral = 0.0; // of (y - y0) since the step
+    size_t total = 0;
+
+    OnlineFOPDTEstimate current;
+};
+
+} // namespace autotune::process_models
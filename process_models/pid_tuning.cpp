@@ -0,0 +1,119 @@
+#include "pid_tuning.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace autotune::process_models
+{
+
+PIDGains zieglerNicholsPID(double ku, double pu, double processSign)
+{
+    PIDGains g;
+    if (ku <= 0 || pu <= 0)
+        return g;
+
+    double sign = processSign < 0 ? -1.0 : 1.0;
+    double kc = 0.6 * ku * sign;
+    double tauI = pu / 2.0;
+    double tauD = pu / 8.0;
+
+    g.kp = kc;
+    g.ki = kc / tauI;
+    g.kd = kc * tauD;
+    return g;
+}
+
+PIDGains zieglerNicholsPI(double ku, double pu, double processSign)
+{
+    PIDGains g;
+    if (ku <= 0 || pu <= 0)
+        return g;
+
+    double sign = processSign < 0 ? -1.0 : 1.0;
+    double kc = 0.45 * ku * sign;
+    double tauI = pu / 1.2;
+
+    g.kp = kc;
+    g.ki = kc / tauI;
+    return g;
+}
+
+// Very small dead times would give unbounded gains.
+static double effectiveTheta(const FOPDTParameters& model)
+{
+    return std::max(model.theta, 0.1);
+}
+
+PIDGains imcPID(const FOPDTParameters& model, double ratio)
+{
+    PIDGains g;
+    double theta = effectiveTheta(model);
+    double epsilon = theta * ratio;
+    double denominator = model.k * (2.0 * epsilon + theta);
+    if (std::abs(denominator) < 1e-9)
+        return g;
+
+    double kc = (2.0 * model.tau + theta) / denominator;
+    double tauI = model.tau + theta / 2.0;
+    double tauD = (model.tau * theta) / (2.0 * model.tau + theta);
+
+    g.kp = kc;
+    g.ki = std::abs(tauI) > 1e-9 ? kc / tauI : 0.0;
+    g.kd = kc * tauD;
+    return g;
+}
+
+PIDGains imcPI(const FOPDTParameters& model, double ratio)
+{
+    PIDGains g;
+    double theta = effectiveTheta(model);
+    double epsilon = theta * ratio;
+    double denominator = 2.0 * model.k * epsilon;
+    if (std::abs(denominator) < 1e-9)
+        return g;
+
+    double kc = (2.0 * model.tau + theta) / denominator;
+    double tauI = model.tau + theta / 2.0;
+
+    g.kp = kc;
+    g.ki = std::abs(tauI) > 1e-9 ? kc / tauI : 0.0;
+    return g;
+}
+
+PIDGains imcPIDSecondOrder(double k, double tau1, double tau2, double theta,
+                           double ratio)
+{
+    PIDGains g;
+    theta = std::max(theta, 0.1);
+    double denominator = k * (ratio * theta + theta);
+    double tauI = tau1 + tau2;
+    if (std::abs(denominator) < 1e-9 || tauI < 1e-9)
+        return g;
+
+    double kc = tauI / denominator;
+    double tauD = tau1 * tau2 / tauI;
+
+    g.kp = kc;
+    g.ki = kc / tauI;
+    g.kd = kc * tauD;
+    return g;
+}
+
+PIDGains simcPIIntegrating(double k, double theta, double ratio)
+{
+    PIDGains g;
+    theta = std::max(theta, 0.1);
+    double lambda = ratio * theta;
+    double denominator = k * (lambda + theta);
+    if (std::abs(denominator) < 1e-9)
+        return g;
+
+    double kc = 1.0 / denominator;
+    double tauI = 4.0 * (lambda + theta);
+
+    g.kp = kc;
+    g.ki = kc / tauI;
+    return g;
+}
+
+} // namespace autotune::process_models
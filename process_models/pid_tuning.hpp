@@ -0,0 +1,52 @@
+#pragma once
+
+#include "fopdt.hpp"
+
+namespace autotune::process_models
+{
+
+struct PIDGains
+{
+    double kp = 0.0;
+    double ki = 0.0;
+    double kd = 0.0;
+};
+
+/**
+ * @brief Classic Ziegler-Nichols PID rules from the ultimate point.
+ * @param ku Ultimate gain magnitude
+ * @param pu Ultimate period, seconds
+ * @param processSign Sign of the process gain; the gains take the same
+ *        sign, matching the IMC rules in tool/app/pid_algo.py.
+ */
+PIDGains zieglerNicholsPID(double ku, double pu, double processSign);
+
+/** Ziegler-Nichols PI rules from the ultimate point. */
+PIDGains zieglerNicholsPI(double ku, double pu, double processSign);
+
+/**
+ * @brief IMC PID rules for an FOPDT model, as in tool/app/pid_algo.py.
+ * @param ratio Closed-loop time constant over dead time (epsilon/theta)
+ */
+PIDGains imcPID(const FOPDTParameters& model, double ratio);
+
+/** IMC "improved PI" rules, as in tool/app/pid_algo.py. */
+PIDGains imcPI(const FOPDTParameters& model, double ratio);
+
+/**
+ * @brief IMC PID rules for an overdamped second-order model with dead
+ *        time, k e^(-theta s) / ((tau1 s + 1)(tau2 s + 1)).
+ *
+ * The controller zeros cancel both lags; epsilon = ratio * theta as for
+ * the FOPDT rules.
+ */
+PIDGains imcPIDSecondOrder(double k, double tau1, double tau2, double theta,
+                           double ratio);
+
+/**
+ * @brief SIMC PI rules for an integrating process with dead time,
+ *        k e^(-theta s) / s (k per second).
+ */
+PIDGains simcPIIntegrating(double k, double theta, double ratio);
+
+} // namespace autotune::process_models
@@ -0,0 +1,177 @@
+#include "relay.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace autotune::process_models
+{
+
+void RelayCycleTracker::reset()
+{
+    halves.clear();
+    started = false;
+    lastHigh = false;
+}
+
+void RelayCycleTracker::update(double time, double temp, bool relayHigh)
+{
+    if (!started || relayHigh != lastHigh)
+    {
+        // The first sample only fixes the initial relay state; cycles
+        // start at the first real switch.
+        if (started)
+            halves.push_back({time, relayHigh, temp, time});
+        started = true;
+        lastHigh = relayHigh;
+        return;
+    }
+
+    if (halves.empty())
+        return;
+
+    // High duty cools, so after switching high the temperature peaks and
+    // after switching low it bottoms out.
+    auto& h = halves.back();
+    if (h.high ? temp > h.extreme : temp < h.extreme)
+    {
+        h.extreme = temp;
+        h.extremeTime = time;
+    }
+}
+
+size_t RelayCycleTracker::cycles() const
+{
+    // A cycle is two completed half-cycles; the last one is still open.
+    return halves.size() >= 3 ? halves.size() - 2 : 0;
+}
+
+std::optional<RelayOscillation> RelayCycleTracker::measure(size_t n) const
+{
+    if (n == 0 || cycles() < n)
+        return std::nullopt;
+
+    RelayOscillation osc;
+    osc.cycles = n;
+    size_t last = halves.size() - 1; // open half-cycle
+    for (size_t c = 0; c < n; ++c)
+    {
+        size_t i = last - 2 - c;
+        osc.period += halves[i + 2].switchTime - halves[i].switchTime;
+        osc.amplitude +=
+            std::abs(halves[i].extreme - halves[i + 1].extreme) / 2.0;
+        osc.deadTime += (halves[i].extremeTime - halves[i].switchTime +
+                         halves[i + 1].extremeTime -
+                         halves[i + 1].switchTime) /
+                        2.0;
+    }
+    osc.period /= static_cast<double>(n);
+    osc.amplitude /= static_cast<double>(n);
+    osc.deadTime /= static_cast<double>(n);
+    return osc;
+}
+
+bool RelayCycleTracker::stable(size_t n, double tol) const
+{
+    auto osc = measure(n);
+    if (!osc || osc->period <= 0 || osc->amplitude <= 0)
+        return false;
+
+    size_t last = halves.size() - 1;
+    for (size_t c = 0; c < n; ++c)
+    {
+        size_t i = last - 2 - c;
+        double period = halves[i + 2].switchTime - halves[i].switchTime;
+        double amplitude =
+            std::abs(halves[i].extreme - halves[i + 1].extreme) / 2.0;
+        if (std::abs(period - osc->period) > tol * osc->period ||
+            std::abs(amplitude - osc->amplitude) > tol * osc->amplitude)
+            return false;
+    }
+    return true;
+}
+
+// Oscillation period of an FOPDT loop under the relay, given tau and the
+// measured amplitude and dead time; K*d follows from the amplitude.
+static double relayPeriod(double tau, double a, double h, double theta,
+                          double& kd)
+{
+    double e = std::exp(-theta / tau);
+    kd = (a - h * e) / (1.0 - e);
+    if (kd <= h)
+        return -1.0;
+    // 2*tau*ln((2Kd*e^(theta/tau) - Kd + h)/(Kd - h)), kept finite.
+    return 2.0 * theta +
+           2.0 * tau * std::log((2.0 * kd - (kd - h) * e) / (kd - h));
+}
+
+RelayIdentification identifyRelay(const RelayOscillation& osc,
+                                  double relayAmplitude, double hysteresis,
+                                  double processSign)
+{
+    RelayIdentification id;
+    double a = osc.amplitude;
+    double d = std::abs(relayAmplitude);
+    double h = std::max(hysteresis, 0.0);
+    if (a <= 0 || d <= 0 || osc.period <= 0)
+        return id;
+
+    double effective = a > h ? std::sqrt(a * a - h * h) : a;
+    id.ku = 4.0 * d / (std::numbers::pi * effective);
+    id.pu = osc.period;
+
+    double theta = osc.deadTime;
+    if (theta <= 0 || a <= h)
+        return id;
+
+    // Scan tau on a log grid for the sign change of the period error,
+    // then bisect.
+    auto error = [&](double tau, double& kd) {
+        double p = relayPeriod(tau, a, h, theta, kd);
+        return p < 0 ? -osc.period : p - osc.period;
+    };
+
+    double kd = 0.0;
+    double lo = theta * 1e-3;
+    double errLo = error(lo, kd);
+    double hi = lo;
+    bool bracketed = false;
+    for (int i = 0; i < 200 && !bracketed; ++i)
+    {
+        hi = lo * std::pow(10.0, 0.05);
+        double errHi = error(hi, kd);
+        if ((errLo < 0) != (errHi < 0))
+            bracketed = true;
+        else
+        {
+            lo = hi;
+            errLo = errHi;
+        }
+    }
+    if (!bracketed)
+        return id;
+
+    for (int i = 0; i < 60; ++i)
+    {
+        double mid = 0.5 * (lo + hi);
+        double errMid = error(mid, kd);
+        if ((errMid < 0) == (errLo < 0))
+        {
+            lo = mid;
+            errLo = errMid;
+        }
+        else
+            hi = mid;
+    }
+
+    double tau = 0.5 * (lo + hi);
+    relayPeriod(tau, a, h, theta, kd);
+    double gain = kd / d;
+    id.fopdt.k = processSign < 0 ? -gain : gain;
+    id.fopdt.tau = tau;
+    id.fopdt.theta = theta;
+    id.fopdtValid = true;
+    return id;
+}
+
+} // namespace autotune::process_models
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "fopdt.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace autotune::process_models
+{
+
+/** Averages over the last few full cycles of a relay oscillation. */
+struct RelayOscillation
+{
+    double period = 0.0;    // seconds
+    double amplitude = 0.0; // degC, half of peak-to-peak
+    double deadTime = 0.0;  // switch to following extremum, seconds
+    size_t cycles = 0;
+};
+
+/**
+ * @brief Follows a relay-feedback run: the time of every relay switch and
+ *        the temperature extremum reached before the next one.
+ *
+ * After a switch the temperature keeps moving the old way for the dead
+ * time and then turns, so each half-cycle holds one extremum.
+ */
+class RelayCycleTracker
+{
+  public:
+    void reset();
+
+    /** @param relayHigh Relay output in effect after this sample. */
+    void update(double time, double temp, bool relayHigh);
+
+    /** Completed full cycles. */
+    size_t cycles() const;
+
+    /** Average of the last @p n full cycles, if that many completed. */
+    std::optional<RelayOscillation> measure(size_t n) const;
+
+    /** Periods and amplitudes of the last @p n cycles all lie within
+     *  @p tol (relative) of their mean. */
+    bool stable(size_t n, double tol) const;
+
+  private:
+    struct HalfCycle
+    {
+        double switchTime;
+        bool high;
+        double extreme;
+        double extremeTime;
+    };
+
+    std::vector<HalfCycle> halves;
+    bool lastHigh = false;
+    bool started = false;
+};
+
+struct RelayIdentification
+{
+    double ku = 0.0; // ultimate gain magnitude, duty% per degC
+    double pu = 0.0; // ultimate period, seconds
+    FOPDTParameters fopdt;
+    bool fopdtValid = false;
+};
+
+/**
+ * @brief Ultimate point and FOPDT model from a relay oscillation.
+ *
+ * Ku = 4d / (pi * sqrt(a^2 - h^2)) (describing function) and Pu is the
+ * measured period. The FOPDT model takes the measured dead time and solves
+ * the exact relay oscillation of an FOPDT loop,
+ *   a = K*d*(1 - e^(-theta/tau)) + h*e^(-theta/tau)
+ *   P = 2*tau*ln((2*K*d*e^(theta/tau) - K*d + h) / (K*d - h))
+ * for K and tau.
+ *
+ * @param relayAmplitude Half the difference of the two duties, duty %
+ * @param hysteresis Relay hysteresis, degC
+ * @param processSign Sign of the process gain (negative for fans)
+ */
+RelayIdentification identifyRelay(const RelayOscillation& osc,
+                                  double relayAmplitude, double hysteresis,
+                                  double processSign);
+
+} // namespace autotune::process_models
@@ -0,0 +1,265 @@
+#include "step_model.hpp"
+
+#include "../solvers/nelder_mead.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace autotune::process_models
+{
+
+namespace
+{
+
+constexpr double kInfeasible = 1e15;
+
+// Squared error of the deviation @p response(t) from the baseline, t in
+// seconds after the step.
+template <typename Response>
+double stepSSD(const StepRecord& r, const Response& response)
+{
+    double ssd = 0.0;
+    for (size_t i = 0; i < r.time.size(); ++i)
+    {
+        double e = r.temp[i] - r.baseline - response(r.time[i] - r.stepTime);
+        ssd += e * e;
+    }
+    return ssd;
+}
+
+// Restarting resets the simplex size, as in identifyRecord().
+template <size_t N, typename Cost>
+std::array<double, N> minimise(std::array<double, N> p, const Cost& cost)
+{
+    solvers::NelderMeadOptions opt;
+    opt.maxIter = 400;
+    for (int restart = 0; restart < 3; ++restart)
+        p = solvers::NelderMead::solve(p, cost, opt).params;
+    return p;
+}
+
+// Error and information criteria of a fit of @p k parameters; valid stays
+// unset when the fit failed.
+ModelFit score(const char* model, std::vector<std::string> names,
+               const StepRecord& r, double ssd, size_t k)
+{
+    ModelFit fit;
+    fit.model = model;
+    fit.names = std::move(names);
+    double n = static_cast<double>(r.time.size());
+    if (ssd >= kInfeasible || !(ssd > 0.0))
+        return fit;
+
+    fit.parameters = k;
+    fit.rmse = std::sqrt(ssd / n);
+    double dk = static_cast<double>(k);
+    fit.aic = n * std::log(ssd / n) + 2.0 * dk;
+    fit.bic = n * std::log(ssd / n) + dk * std::log(n);
+    fit.valid = true;
+    return fit;
+}
+
+// p = [kStep, tau, theta]
+class FOPDTModel : public StepModel
+{
+  public:
+    const char* name() const override
+    {
+        return "FOPDT";
+    }
+
+    ModelFit fit(const StepRecord& r, const FOPDTParameters& f,
+                 double ratio) const override
+    {
+        auto cost = [&r](const std::array<double, 3>& p) {
+            if (p[1] < 0.1 || p[2] < 0.0)
+                return kInfeasible;
+            return r.ssd(r.baseline, {p[0], p[1], p[2]});
+        };
+        auto p = minimise(std::array{f.k * r.dutyChange, std::max(f.tau, 1.0),
+                                     std::max(f.theta, 0.0)},
+                          cost);
+
+        auto fit = score(name(), {"k", "tau", "theta"}, r, cost(p), p.size());
+        if (fit.valid)
+        {
+            FOPDTParameters perDuty{p[0] / r.dutyChange, p[1], p[2]};
+            fit.params = {perDuty.k, perDuty.tau, perDuty.theta};
+            fit.pid = imcPID(perDuty, ratio);
+        }
+        return fit;
+    }
+};
+
+// p = [kStep, tau1, tau2, theta], overdamped or critically damped.
+class SOPDTModel : public StepModel
+{
+  public:
+    const char* name() const override
+    {
+        return "SOPDT";
+    }
+
+    // Skogestad's half rule read backwards: half the apparent dead time
+    // is a second, smaller lag.
+    ModelFit fit(const StepRecord& r, const FOPDTParameters& f,
+                 double ratio) const override
+    {
+        auto cost = [&r](const std::array<double, 4>& p) {
+            if (p[1] < 0.1 || p[2] < 0.1 || p[3] < 0.0)
+                return kInfeasible;
+            return stepSSD(r, [&p](double t) { return response(p, t); });
+        };
+        double theta = std::max(f.theta, 0.0);
+        auto p = minimise(std::array{f.k * r.dutyChange, std::max(f.tau, 1.0),
+                                     std::max(theta / 2.0, 1.0), theta / 2.0},
+                          cost);
+
+        auto fit = score(name(), {"k", "tau1", "tau2", "theta"}, r, cost(p),
+                         p.size());
+        if (fit.valid)
+        {
+            fit.params = {p[0] / r.dutyChange, std::max(p[1], p[2]),
+                          std::min(p[1], p[2]), p[3]};
+            fit.pid = imcPIDSecondOrder(p[0] / r.dutyChange, p[1], p[2], p[3],
+                                        ratio);
+        }
+        return fit;
+    }
+
+  private:
+    static double response(const std::array<double, 4>& p, double t)
+    {
+        double s = t - p[3];
+        if (s <= 0)
+            return 0.0;
+        double t1 = p[1];
+        double t2 = p[2];
+        if (std::abs(t1 - t2) < 1e-6 * std::max(t1, t2))
+            return p[0] * (1.0 - (1.0 + s / t1) * std::exp(-s / t1));
+        return p[0] *
+               (1.0 - (t1 * std::exp(-s / t1) - t2 * std::exp(-s / t2)) /
+                          (t1 - t2));
+    }
+};
+
+// p = [slope of this step (degC/s), theta]
+class IPDTModel : public StepModel
+{
+  public:
+    const char* name() const override
+    {
+        return "IPDT";
+    }
+
+    // Starts from the FOPDT response's initial slope.
+    ModelFit fit(const StepRecord& r, const FOPDTParameters& f,
+                 double ratio) const override
+    {
+        auto cost = [&r](const std::array<double, 2>& p) {
+            if (p[1] < 0.0)
+                return kInfeasible;
+            return stepSSD(r, [&p](double t) {
+                return t <= p[1] ? 0.0 : p[0] * (t - p[1]);
+            });
+        };
+        auto p = minimise(std::array{f.k * r.dutyChange / std::max(f.tau, 1.0),
+                                     std::max(f.theta, 0.0)},
+                          cost);
+
+        auto fit = score(name(), {"k", "theta"}, r, cost(p), p.size());
+        if (fit.valid)
+        {
+            fit.params = {p[0] / r.dutyChange, p[1]};
+            fit.pid = simcPIIntegrating(p[0] / r.dutyChange, p[1], ratio);
+        }
+        return fit;
+    }
+};
+
+// p = [kStep, tau, theta, drift (degC/s), baseline]: ambient drift through
+// the whole record, zero at the step, where the temperature is baseline.
+class DriftFOPDTModel : public StepModel
+{
+  public:
+    const char* name() const override
+    {
+        return "FOPDT+drift";
+    }
+
+    ModelFit fit(const StepRecord& r, const FOPDTParameters& f,
+                 double ratio) const override
+    {
+        auto cost = [&r](const std::array<double, 5>& p) {
+            if (p[1] < 0.1 || p[2] < 0.0)
+                return kInfeasible;
+            return r.ssd(p[4], {p[0], p[1], p[2], p[3]});
+        };
+        auto p = minimise(std::array{f.k * r.dutyChange, std::max(f.tau, 1.0),
+                                     std::max(f.theta, 0.0), 0.0, r.baseline},
+                          cost);
+
+        auto fit = score(name(), {"k", "tau", "theta", "drift", "baseline"},
+                         r, cost(p), p.size());
+        if (fit.valid)
+        {
+            FOPDTParameters perDuty{p[0] / r.dutyChange, p[1], p[2]};
+            fit.params = {perDuty.k, perDuty.tau, perDuty.theta, p[3], p[4]};
+            fit.pid = imcPID(perDuty, ratio);
+        }
+        return fit;
+    }
+};
+
+} // namespace
+
+StepRecord::StepRecord(std::span<const double> time,
+                       std::span<const double> temp, double stepTime,
+                       double baseline, double dutyChange) :
+    time(time), temp(temp), stepTime(stepTime), baseline(baseline),
+    dutyChange(dutyChange), ssd(time, temp, stepTime)
+{}
+
+std::vector<std::unique_ptr<StepModel>> makeStepModels()
+{
+    std::vector<std::unique_ptr<StepModel>> models;
+    models.push_back(std::make_unique<FOPDTModel>());
+    models.push_back(std::make_unique<SOPDTModel>());
+    models.push_back(std::make_unique<IPDTModel>());
+    models.push_back(std::make_unique<DriftFOPDTModel>());
+    return models;
+}
+
+std::vector<ModelFit> fitStepModels(
+    std::span<const double> time, std::span<const double> temp,
+    double stepTime, double baseline, double dutyChange,
+    const FOPDTParameters& start,
+    std::span<const std::unique_ptr<StepModel>> models, core::ThreadPool* pool,
+    double imcRatio)
+{
+    std::vector<ModelFit> fits(models.size());
+    if (time.size() != temp.size() || time.size() < 8 ||
+        std::abs(dutyChange) < 1e-6)
+        return fits;
+
+    const StepRecord record(time, temp, stepTime, baseline, dutyChange);
+    auto fit = [&](size_t i) {
+        fits[i] = models[i]->fit(record, start, imcRatio);
+    };
+    if (pool)
+        pool->parallelFor(models.size(), fit);
+    else
+        for (size_t i = 0; i < models.size(); ++i)
+            fit(i);
+
+    std::stable_sort(fits.begin(), fits.end(),
+                     [](const ModelFit& a, const ModelFit& b) {
+                         if (a.valid != b.valid)
+                             return a.valid;
+                         return a.bic < b.bic;
+                     });
+    return fits;
+}
+
+} // namespace autotune::process_models
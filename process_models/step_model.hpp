@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../core/thread_pool.hpp"
+#include "fopdt.hpp"
+#include "fopdt_kernel.hpp"
+#include "pid_tuning.hpp"
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace autotune::process_models
+{
+
+struct ModelFit
+{
+    std::string model;
+    std::vector<std::string> names;
+    std::vector<double> params; // gains per duty percent
+    size_t parameters = 0;      // fitted parameters, a fitted baseline too
+    double rmse = 0.0;          // degC
+    double aic = 0.0;
+    double bic = 0.0;
+    PIDGains pid;
+    bool valid = false;
+};
+
+/** One step record, shared by every model fitted to it. */
+struct StepRecord
+{
+    StepRecord(std::span<const double> time, std::span<const double> temp,
+               double stepTime, double baseline, double dutyChange);
+
+    std::span<const double> time;
+    std::span<const double> temp;
+    double stepTime;
+    double baseline; // mean before the step
+    double dutyChange;
+    StepSSD ssd; // FOPDT (+drift) error over the record
+};
+
+/**
+ * @brief A process model that can be fitted to a step response.
+ *
+ * Parameters are kept in step units (the gain is the total temperature
+ * change of this step) while fitting and converted per duty percent for
+ * reporting and tuning.
+ */
+class StepModel
+{
+  public:
+    virtual ~StepModel() = default;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Fit to @p record starting from an FOPDT fit of it, and tune
+     *        PID gains for the result; epsilon = ratio * dead time.
+     *        The fit's valid flag is unset if it failed.
+     */
+    virtual ModelFit fit(const StepRecord& record, const FOPDTParameters& start,
+                         double ratio) const = 0;
+};
+
+/** FOPDT, SOPDT, IPDT and FOPDT with linear drift. */
+std::vector<std::unique_ptr<StepModel>> makeStepModels();
+
+/**
+ * @brief Fit every model in @p models to the same step record and rank
+ *        them, lowest BIC first.
+ *
+ * The baseline is held at @p baseline, the pre-step mean, except by
+ * FOPDT+drift: under drift that mean is off the level at the step by half
+ * the drift over the pre-step window, so it fits the baseline as one more
+ * parameter. Each fit starts from @p start and runs on @p pool and the
+ * calling thread (serially when @p pool is null). AIC = n ln(SSD/n) + 2p
+ * and BIC = n ln(SSD/n) + p ln n over the n samples. Models that failed to
+ * fit sort last with valid unset.
+ */
+std::vector<ModelFit> fitStepModels(
+    std::span<const double> time, std::span<const double> temp,
+    double stepTime, double baseline, double dutyChange,
+    const FOPDTParameters& start,
+    std::span<const std::unique_ptr<StepModel>> models, core::ThreadPool* pool,
+    double imcRatio);
+
+} // namespace autotune::process_models
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace autotune::solvers
+{
+
+/** Size of a LevenbergMarquardt problem only known at run time. */
+inline constexpr size_t dynamicSize = 0;
+
+/**
+ * @brief Levenberg-Marquardt least squares for small, fixed-size problems.
+ *
+ * Minimises sum(r_i(p)^2) over N parameters from residuals with analytic
+ * derivatives. The normal equations J'J and J'r are accumulated residual
+ * by residual, so the Jacobian is never stored and a fixed-size solve
+ * allocates nothing. Steps are scaled by diag(J'J) (Marquardt) and
+ * projected onto the box [lower, upper]. Everything is deterministic.
+ *
+ * With N = dynamicSize the parameters are a std::vector whose size is set
+ * by the start point, for problems that grow with their input.
+ */
+template <size_t N>
+class LevenbergMarquardt
+{
+  public:
+    using Vector = std::conditional_t<N == dynamicSize, std::vector<double>,
+                                      std::array<double, N>>;
+
+    struct Options
+    {
+        int maxIter;
+        double ftol;  // stop when the cost falls by less than this fraction
+        double xtol;  // stop when no parameter moves by more than this
+        Vector lower; // box bounds, +-infinity for none
+        Vector upper;
+    };
+
+    struct Result
+    {
+        Vector params{};
+        double cost = 0.0; // sum of squared residuals
+        int iterations = 0;
+        int evaluations = 0; // passes over the residuals
+        bool converged = false;
+    };
+
+    /** Defaults for @p m parameters (ignored unless dynamic). */
+    static Options defaults(size_t m = N)
+    {
+        Options o;
+        o.maxIter = 50;
+        o.ftol = 1e-10;
+        o.xtol = 1e-8;
+        o.lower = zeros(m);
+        o.upper = zeros(m);
+        std::fill(o.lower.begin(), o.lower.end(),
+                  -std::numeric_limits<double>::infinity());
+        std::fill(o.upper.begin(), o.upper.end(),
+                  std::numeric_limits<double>::infinity());
+        return o;
+    }
+
+    /**
+     * @brief Solve from @p p.
+     * @param count Number of residuals.
+     * @param residual Callable double(const Vector& p, size_t i, Vector& g)
+     *        returning r_i and filling g with dr_i/dp.
+     */
+    template <typename Residual>
+    static Result solve(Vector p, size_t count, Residual&& residual,
+                        const Options& opt)
+    {
+        Result res;
+        const size_t m = p.size();
+        project(p, opt);
+
+        Normal cur = accumulate(p, count, residual);
+        res.evaluations = 1;
+        double lambda = 1e-3;
+        double nu = 2.0;
+
+        for (int iter = 0; iter < opt.maxIter; ++iter)
+        {
+            res.iterations = iter + 1;
+
+            // Solve (J'J + lambda diag(J'J)) d = -J'r, raising lambda
+            // until the step lowers the cost.
+            bool accepted = false;
+            bool small = false;
+            while (!accepted && lambda < 1e12)
+            {
+                Matrix a = cur.jtj;
+                for (size_t j = 0; j < m; ++j)
+                    a[j * m + j] +=
+                        lambda * std::max(cur.jtj[j * m + j], 1e-12);
+
+                Vector d = zeros(m);
+                for (size_t j = 0; j < m; ++j)
+                    d[j] = -cur.jtr[j];
+                if (!cholesky(a, d))
+                {
+                    lambda *= nu;
+                    nu *= 2.0;
+                    continue;
+                }
+
+                Vector trial = p;
+                double moved = 0.0;
+                for (size_t j = 0; j < m; ++j)
+                    trial[j] += d[j];
+                project(trial, opt);
+                for (size_t j = 0; j < m; ++j)
+                    moved = std::max(moved, std::abs(trial[j] - p[j]) /
+                                                (std::abs(p[j]) + opt.xtol));
+                if (moved <= opt.xtol)
+                {
+                    small = true;
+                    break;
+                }
+
+                Normal next = accumulate(trial, count, residual);
+                res.evaluations++;
+                if (next.cost < cur.cost)
+                {
+                    double drop = (cur.cost - next.cost) /
+                                  std::max(cur.cost, 1e-300);
+                    p = trial;
+                    cur = next;
+                    lambda = std::max(lambda / 3.0, 1e-12);
+                    nu = 2.0;
+                    accepted = true;
+                    if (drop <= opt.ftol)
+                        small = true;
+                }
+                else
+                {
+                    lambda *= nu;
+                    nu *= 2.0;
+                }
+            }
+
+            if (small || !accepted)
+            {
+                res.converged = small;
+                break;
+            }
+        }
+
+        res.params = p;
+        res.cost = cur.cost;
+        return res;
+    }
+
+  private:
+    // Row-major m x m matrices share the vector type: N * N doubles, or
+    // a vector sized at run time.
+    using Matrix = std::conditional_t<N == dynamicSize, std::vector<double>,
+                                      std::array<double, N * N>>;
+
+    struct Normal
+    {
+        Matrix jtj{};
+        Vector jtr{};
+        double cost = 0.0;
+    };
+
+    static Vector zeros(size_t m)
+    {
+        Vector v{};
+        if constexpr (N == dynamicSize)
+            v.assign(m, 0.0);
+        return v;
+    }
+
+    template <typename Residual>
+    static Normal accumulate(const Vector& p, size_t count,
+                             Residual& residual)
+    {
+        const size_t m = p.size();
+        Normal n;
+        n.jtr = zeros(m);
+        if constexpr (N == dynamicSize)
+            n.jtj.assign(m * m, 0.0);
+        Vector g = zeros(m);
+        for (size_t i = 0; i < count; ++i)
+        {
+            double r = residual(p, i, g);
+            n.cost += r * r;
+            for (size_t a = 0; a < m; ++a)
+            {
+                n.jtr[a] += g[a] * r;
+                for (size_t b = 0; b <= a; ++b)
+                    n.jtj[a * m + b] += g[a] * g[b];
+            }
+        }
+        for (size_t a = 0; a < m; ++a)
+        {
+            for (size_t b = a + 1; b < m; ++b)
+                n.jtj[a * m + b] = n.jtj[b * m + a];
+        }
+        return n;
+    }
+
+    static void project(Vector& p, const Options& opt)
+    {
+        for (size_t j = 0; j < p.size(); ++j)
+            p[j] = std::min(std::max(p[j], opt.lower[j]), opt.upper[j]);
+    }
+
+    // Solve a x = b in place (x returned in b); false if a is not
+    // positive definite.
+    static bool cholesky(Matrix& a, Vector& b)
+    {
+        const size_t m = b.size();
+        for (size_t j = 0; j < m; ++j)
+        {
+            double d = a[j * m + j];
+            for (size_t k = 0; k < j; ++k)
+                d -= a[j * m + k] * a[j * m + k];
+            if (!(d > 0.0))
+                return false;
+            a[j * m + j] = std::sqrt(d);
+            for (size_t i = j + 1; i < m; ++i)
+            {
+                double s = a[i * m + j];
+                for (size_t k = 0; k < j; ++k)
+                    s -= a[i * m + k] * a[j * m + k];
+                a[i * m + j] = s / a[j * m + j];
+            }
+        }
+        for (size_t i = 0; i < m; ++i)
+        {
+            for (size_t k = 0; k < i; ++k)
+                b[i] -= a[i * m + k] * b[k];
+            b[i] /= a[i * m + i];
+        }
+        for (size_t i = m; i-- > 0;)
+        {
+            for (size_t k = i + 1; k < m; ++k)
+                b[i] -= a[k * m + i] * b[k];
+            b[i] /= a[i * m + i];
+        }
+        return true;
+    }
+};
+
+} // namespace autotune::solvers
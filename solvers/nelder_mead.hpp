@@ -1,28 +1,65 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <functional>
-#include <iostream>
+#include <limits>
 #include <vector>
 
 namespace autotune::solvers
 {
 
+struct NelderMeadOptions
+{
+    int maxIter = 200;
+    // Stop once the vertex costs span at most ftol and every vertex lies
+    // within xtol of the best in every coordinate.
+    double ftol = 1e-6;
+    double xtol = std::numeric_limits<double>::infinity();
+};
+
+template <typename Params>
+struct NelderMeadSolution
+{
+    Params params{};
+    double cost = 0.0;
+    int iterations = 0;
+    int evaluations = 0;
+    bool converged = false;
+};
+
+template <size_t N>
+using NelderMeadResult = NelderMeadSolution<std::array<double, N>>;
+
 /**
  * @brief Nelder-Mead Optimization Solver.
  * Minimizes a cost function of N variables.
+ *
+ * One implementation serves both entry points: the simplex is held in
+ * std::array when the dimension is known at compile time and in
+ * std::vector when it is not. The fixed-size solve() takes the cost
+ * functor as a template parameter, so the cost can be inlined. Neither
+ * allocates inside the loop, and only the best, second-worst and worst
+ * vertices are located per iteration; the simplex is never sorted.
  */
 class NelderMead
 {
   public:
     using CostFunction = std::function<double(const std::vector<double>&)>;
 
-    struct Point
+    /** Solve a problem of compile-time dimension N. */
+    template <size_t N, typename Cost>
+    static NelderMeadResult<N> solve(const std::array<double, N>& initial,
+                                     Cost&& costFunc,
+                                     const NelderMeadOptions& opt = {})
     {
-        std::vector<double> params;
-        double cost;
-    };
+        static_assert(N > 0);
+        std::array<std::array<double, N>, N + 1> x;
+        std::array<double, N + 1> f;
+        return run(initial, x, f, costFunc, opt);
+    }
 
     /**
      * @brief Solve the optimization problem.
@@ -30,166 +67,191 @@ class NelderMead
      * @param costFunc Function to minimize.
      * @param maxIter Maximum iterations (default 200).
      * @return Optimized parameters.
+     *
+     * For problems whose dimension is only known at run time; the simplex
+     * is held in std::vector.
      */
     static std::vector<double> solve(const std::vector<double>& initialParams,
                                      CostFunction costFunc, int maxIter = 200)
     {
-        size_t n = initialParams.size(); // Number of dimensions
-        std::vector<Point> simplex(n + 1);
+        if (initialParams.empty())
+            return initialParams;
+        NelderMeadOptions opt;
+        opt.maxIter = maxIter;
+        std::vector<std::vector<double>> x(initialParams.size() + 1);
+        std::vector<double> f(initialParams.size() + 1);
+        return run(initialParams, x, f, costFunc, opt).params;
+    }
 
-        // 1. Initialize Simplex
-        // P0 = initial guess
-        simplex[0].params = initialParams;
-        simplex[0].cost = costFunc(initialParams);
+  private:
+    // x and f hold n + 1 vertices; Vec is std::array<double, n> or a
+    // std::vector<double> of size n.
+    template <typename Vec, typename Simplex, typename Costs, typename Cost>
+    static NelderMeadSolution<Vec> run(const Vec& initial, Simplex& x,
+                                       Costs& f, Cost& costFunc,
+                                       const NelderMeadOptions& opt)
+    {
+        const size_t n = initial.size();
+        NelderMeadSolution<Vec> res;
 
-        // P1..Pn = perturbed P0
+        x[0] = initial;
+        f[0] = costFunc(x[0]);
         for (size_t i = 1; i <= n; ++i)
         {
-            simplex[i].params = initialParams;
             // Perturb i-th dimension by 5% or minimally 0.00025
-            if (std::abs(simplex[i].params[i - 1]) > 1e-9)
-            {
-                simplex[i].params[i - 1] *= 1.05;
-            }
-            else
-            {
-                simplex[i].params[i - 1] = 0.00025;
-            }
-            simplex[i].cost = costFunc(simplex[i].params);
+            x[i] = initial;
+            double& v = x[i][i - 1];
+            v = std::abs(v) > 1e-9 ? v * 1.05 : 0.00025;
+            f[i] = costFunc(x[i]);
         }
+        res.evaluations = static_cast<int>(n + 1);
 
-        // Parameters
         const double alpha = 1.0; // Reflection
         const double gamma = 2.0; // Expansion
         const double rho = 0.5;   // Contraction
         const double sigma = 0.5; // Shrink
 
-        for (int iter = 0; iter < maxIter; ++iter)
+        // Sized once, from the initial point.
+        Vec centroid = initial;
+        Vec reflected = initial;
+        Vec trial = initial;
+
+        // Point on the line from the centroid through @p from.
+        auto along = [&](double t, const Vec& from, Vec& p) {
+            for (size_t j = 0; j < n; ++j)
+                p[j] = centroid[j] + t * (from[j] - centroid[j]);
+        };
+
+        size_t best = 0;
+        for (int iter = 0; iter < opt.maxIter; ++iter)
         {
-            // 2. Sort Simplex (Best to Worst)
-            std::sort(simplex.begin(), simplex.end(),
-                      [](const Point& a, const Point& b) {
-                          return a.cost < b.cost;
-                      });
-
-            // Best is simplex[0], Worst is simplex[n], Second Worst is
-            // simplex[n-1]
-            const auto& best = simplex[0];
-            const auto& worst = simplex[n];
-            const auto& secondWorst = simplex[n - 1];
-
-            // Check for convergence (simple cost variance check)
-            double range = std::abs(worst.cost - best.cost);
-            if (range < 1e-6)
+            res.iterations = iter + 1;
+
+            best = 0;
+            size_t worst = 0;
+            for (size_t i = 1; i <= n; ++i)
+            {
+                if (f[i] < f[best])
+                    best = i;
+                if (f[i] >= f[worst])
+                    worst = i;
+            }
+            if (best == worst)
+                worst = best == 0 ? 1 : 0;
+            size_t second = best;
+            for (size_t i = 0; i <= n; ++i)
+            {
+                if (i != worst && (second == best || f[i] > f[second]))
+                    second = i;
+            }
+
+            if (converged(x, f, n, best, worst, opt))
+            {
+                res.converged = true;
                 break;
+            }
 
-            // 3. Centroid (of all points except worst)
-            std::vector<double> centroid(n, 0.0);
-            for (size_t i = 0; i < n; ++i)
+            std::fill(centroid.begin(), centroid.end(), 0.0);
+            for (size_t i = 0; i <= n; ++i)
             {
+                if (i == worst)
+                    continue;
                 for (size_t j = 0; j < n; ++j)
-                {
-                    centroid[j] += simplex[i].params[j];
-                }
+                    centroid[j] += x[i][j];
             }
             for (size_t j = 0; j < n; ++j)
-                centroid[j] /= n;
+                centroid[j] /= static_cast<double>(n);
 
-            // 4. Reflection
-            std::vector<double> reflected(n);
-            for (size_t j = 0; j < n; ++j)
-                reflected[j] = centroid[j] +
-                               alpha * (centroid[j] - worst.params[j]);
-
-            double reflectedCost = costFunc(reflected);
+            along(-alpha, x[worst], reflected);
+            double fr = costFunc(reflected);
+            res.evaluations++;
 
-            if (best.cost <= reflectedCost && reflectedCost < secondWorst.cost)
+            if (f[best] <= fr && fr < f[second])
             {
-                // Accept Reflection
-                simplex[n].params = reflected;
-                simplex[n].cost = reflectedCost;
+                x[worst] = reflected;
+                f[worst] = fr;
                 continue;
             }
 
-            // 5. Expansion
-            if (reflectedCost < best.cost)
+            if (fr < f[best])
             {
-                std::vector<double> expanded(n);
-                for (size_t j = 0; j < n; ++j)
-                    expanded[j] = centroid[j] +
-                                  gamma * (reflected[j] - centroid[j]);
-
-                double expandedCost = costFunc(expanded);
-                if (expandedCost < reflectedCost)
+                along(gamma, reflected, trial);
+                double fe = costFunc(trial);
+                res.evaluations++;
+                if (fe < fr)
                 {
-                    simplex[n].params = expanded;
-                    simplex[n].cost = expandedCost;
+                    x[worst] = trial;
+                    f[worst] = fe;
                 }
                 else
                 {
-                    simplex[n].params = reflected;
-                    simplex[n].cost = reflectedCost;
+                    x[worst] = reflected;
+                    f[worst] = fr;
                 }
                 continue;
             }
 
-            // 6. Contraction
-            // Here reflectedCost >= secondWorst.cost
-            bool isOutside =
-                (reflectedCost < worst.cost); // True if better than worst
-
-            std::vector<double> contracted(n);
-            double contractedCost = 0.0;
-
-            if (isOutside) // Outside Contraction (using Reflected)
+            if (fr < f[worst])
             {
-                for (size_t j = 0; j < n; ++j)
-                    contracted[j] = centroid[j] +
-                                    rho * (reflected[j] - centroid[j]);
-                contractedCost = costFunc(contracted);
-
-                if (contractedCost <= reflectedCost)
+                along(rho, reflected, trial);
+                double fc = costFunc(trial);
+                res.evaluations++;
+                if (fc <= fr)
                 {
-                    simplex[n].params = contracted;
-                    simplex[n].cost = contractedCost;
+                    x[worst] = trial;
+                    f[worst] = fc;
                     continue;
                 }
             }
-            else // Inside Contraction (using Worst)
+            else
             {
-                for (size_t j = 0; j < n; ++j)
-                    contracted[j] = centroid[j] +
-                                    rho * (worst.params[j] - centroid[j]);
-                contractedCost = costFunc(contracted);
-
-                if (contractedCost < worst.cost)
+                along(rho, x[worst], trial);
+                double fc = costFunc(trial);
+                res.evaluations++;
+                if (fc < f[worst])
                 {
-                    simplex[n].params = contracted;
-                    simplex[n].cost = contractedCost;
+                    x[worst] = trial;
+                    f[worst] = fc;
                     continue;
                 }
             }
 
-            // 7. Shrink
-            for (size_t i = 1; i <= n; ++i)
+            for (size_t i = 0; i <= n; ++i)
             {
+                if (i == best)
+                    continue;
                 for (size_t j = 0; j < n; ++j)
-                {
-                    simplex[i].params[j] =
-                        best.params[j] +
-                        sigma * (simplex[i].params[j] - best.params[j]);
-                }
-                simplex[i].cost = costFunc(simplex[i].params);
+                    x[i][j] = x[best][j] + sigma * (x[i][j] - x[best][j]);
+                f[i] = costFunc(x[i]);
             }
+            res.evaluations += static_cast<int>(n);
         }
 
-        // Final Sort
-        std::sort(simplex.begin(), simplex.end(),
-                  [](const Point& a, const Point& b) {
-                      return a.cost < b.cost;
-                  });
+        best = static_cast<size_t>(std::min_element(f.begin(), f.end()) -
+                                   f.begin());
+        res.params = x[best];
+        res.cost = f[best];
+        return res;
+    }
 
-        return simplex[0].params;
+    template <typename Simplex, typename Costs>
+    static bool converged(const Simplex& x, const Costs& f, size_t n,
+                          size_t best, size_t worst,
+                          const NelderMeadOptions& opt)
+    {
+        if (std::abs(f[worst] - f[best]) > opt.ftol)
+            return false;
+        if (std::isinf(opt.xtol))
+            return true;
+        for (size_t i = 0; i <= n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (std::abs(x[i][j] - x[best][j]) > opt.xtol)
+                    return false;
+            }
+        }
+        return true;
     }
 };
 
@@ -7,6 +7,7 @@ def parse_data_file(filename, interval, windowsize):
     pwms = []
     temps = []
     first_col_is_time = False
+    step_issued = None
 
     try:
         with open(filename, "r") as f:
@@ -19,6 +20,17 @@ def parse_data_file(filename, interval, windowsize):
                 if not line:
                     continue
 
+                # Metadata, e.g. "#step_issued=600.1,step_acked=600.2"
+                if line.startswith("#"):
+                    for item in line[1:].split(","):
+                        key, _, value = item.partition("=")
+                        if key.strip() == "step_issued":
+                            try:
+                                step_issued = float(value)
+                            except ValueError:
+                                pass
+                    continue
+
                 # Detect delimiter
                 if "," in line:
                     parts = line.split(",")
@@ -68,6 +80,13 @@ def parse_data_file(filename, interval, windowsize):
                 delta_pwm = pwms[i] - pwms[i - 1]
                 break
 
+    # Prefer the logged fan-write time over the first sample after the step
+    if step_idx != -1 and step_issued is not None and first_col_is_time:
+        for i, t in enumerate(times):
+            if t >= step_issued:
+                step_idx = i
+                break
+
     if step_idx == -1:
         print("Warning: No PWM step detected. Plotting all data.")
         step_time = times[0]
@@ -75,6 +94,8 @@ def parse_data_file(filename, interval, windowsize):
         y0 = temps[0]
     else:
         step_time = times[step_idx]
+        if step_issued is not None and first_col_is_time:
+            step_time = step_issued
         start_idx = step_idx
 
         # Calculate y0 (average of windowsize points before step)
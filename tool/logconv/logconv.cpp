@@ -0,0 +1,191 @@
+// Convert step-trigger logs between the binary format and CSV.
+//
+//   autotune-logconv to-csv <in.bin> <out.txt>
+//   autotune-logconv to-bin [--deflate] <in.txt> <out.bin>
+//
+// Both directions stream: only one block or line is held in memory.
+
+#include "experiment/binlog.hpp"
+#include "experiment/log_writer.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace binlog = autotune::experiment::binlog;
+using autotune::experiment::CsvLogSink;
+using autotune::experiment::DataPoint;
+
+constexpr size_t kChunkBytes = 64 * 1024;
+constexpr size_t kSamplesPerBlock = 256;
+constexpr const char* kMetaPrefix = "#meta=";
+
+static int usage()
+{
+    std::cerr << "usage: autotune-logconv to-csv <in.bin> <out.txt>\n"
+                 "       autotune-logconv to-bin [--deflate] <in.txt> "
+                 "<out.bin>\n";
+    return 2;
+}
+
+static void drain(std::ofstream& out, std::string& buf, bool force)
+{
+    if (force || buf.size() >= kChunkBytes)
+    {
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        buf.clear();
+    }
+}
+
+static int toCsv(const std::string& inPath, const std::string& outPath)
+{
+    binlog::Reader reader;
+    if (!reader.open(inPath))
+    {
+        std::cerr << "Not a binary autotune log: " << inPath << "\n";
+        return 1;
+    }
+
+    std::ofstream out(outPath, std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Cannot write " << outPath << "\n";
+        return 1;
+    }
+
+    CsvLogSink csv;
+    std::string buf;
+    csv.header(buf);
+    csv.note(kMetaPrefix + reader.metadata(), buf);
+
+    size_t samples = 0;
+    binlog::Reader::Entry e;
+    while (reader.next(e))
+    {
+        if (e.kind == binlog::Reader::Entry::Kind::Sample)
+        {
+            csv.sample(e.dp, buf);
+            samples++;
+        }
+        else
+        {
+            csv.note(e.note, buf);
+        }
+        drain(out, buf, false);
+    }
+    drain(out, buf, true);
+
+    std::cerr << "Wrote " << samples << " samples to " << outPath << "\n";
+    if (reader.corrupt())
+    {
+        std::cerr << "Input is truncated or corrupt; stopped at the last "
+                     "complete record\n";
+        return 1;
+    }
+    return 0;
+}
+
+static bool parseRow(const std::string& line, DataPoint& dp)
+{
+    std::vector<double> v;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ','))
+    {
+        char* end = nullptr;
+        double d = std::strtod(field.c_str(), &end);
+        if (end == field.c_str())
+            return false;
+        v.push_back(d);
+    }
+    if (v.size() < 7)
+        return false;
+
+    dp = DataPoint{static_cast<int64_t>(v[0]), v[1], v[2], v[3], v[4], v[5],
+                   v[6]};
+    return true;
+}
+
+static int toBin(const std::string& inPath, const std::string& outPath,
+                 bool deflate)
+{
+    std::ifstream in(inPath);
+    if (!in.is_open())
+    {
+        std::cerr << "Cannot read " << inPath << "\n";
+        return 1;
+    }
+
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Cannot write " << outPath << "\n";
+        return 1;
+    }
+
+    // The CSV header, then an optional "#meta=" line from a previous
+    // conversion that carries the original experiment description.
+    std::string line;
+    std::getline(in, line);
+    std::string meta = "{}";
+    std::string firstLine;
+    if (std::getline(in, line))
+    {
+        if (line.starts_with(kMetaPrefix))
+            meta = line.substr(std::string(kMetaPrefix).size());
+        else
+            firstLine = line;
+    }
+
+    binlog::BinLogSink sink(meta, deflate);
+    std::string buf;
+    sink.header(buf);
+
+    size_t samples = 0;
+    size_t inBlock = 0;
+    auto handle = [&](const std::string& l) {
+        if (l.empty())
+            return;
+        if (l.front() == '#')
+        {
+            sink.note(l, buf);
+            inBlock = 0;
+        }
+        else if (DataPoint dp{}; parseRow(l, dp))
+        {
+            sink.sample(dp, buf);
+            samples++;
+            if (++inBlock >= kSamplesPerBlock)
+            {
+                sink.flush(buf);
+                inBlock = 0;
+            }
+        }
+        drain(out, buf, false);
+    };
+
+    handle(firstLine);
+    while (std::getline(in, line))
+        handle(line);
+
+    sink.flush(buf);
+    drain(out, buf, true);
+
+    std::cerr << "Wrote " << samples << " samples to " << outPath << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 3 && args[0] == "to-csv")
+        return toCsv(args[1], args[2]);
+    if (args.size() == 3 && args[0] == "to-bin")
+        return toBin(args[1], args[2], false);
+    if (args.size() == 4 && args[0] == "to-bin" && args[1] == "--deflate")
+        return toBin(args[2], args[3], true);
+    return usage();
+}